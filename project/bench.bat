@@ -0,0 +1,17 @@
+@echo off
+
+REM 2017
+call "C:\Program Files (x86)\Microsoft Visual Studio\2017\Community\VC\Auxiliary\Build\vcvars64.bat"
+
+REM Optimized build, benchmarks are meaningless under -Od
+set BenchCompilerFlags=-MT -nologo -EHsc -Gm- -GR- -EHa- -O2 -Oi -W4 -wd4201 -wd4100 -wd4189 -FC -Z7 -I D:\CProject\include
+
+set BenchLinkerFlags=-opt:ref /LIBPATH:"D:\CProject" include\SDL2.lib include\SDL2main.lib include\SDL2_image.lib include\SDL2_ttf.lib include\SDL2_mixer.lib User32.lib Gdi32.lib /SUBSYSTEM:CONSOLE
+
+mkdir build
+pushd build
+cl  %BenchCompilerFlags% ..\project\code\bench.cpp /link %BenchLinkerFlags%
+
+REM Headless rendering scenarios, JSON on stdout or to -o <file>
+cl  %BenchCompilerFlags% ..\project\code\render_bench.cpp /link %BenchLinkerFlags%
+popd
@@ -0,0 +1,13 @@
+#!/bin/sh
+# Optimized benchmark build, benchmarks are meaningless under -O0
+
+BenchCompilerFlags="-g -O2 -Wall -Wno-unused-parameter $(sdl2-config --cflags)"
+BenchLinkerFlags="$(sdl2-config --libs) -lSDL2_image -lSDL2_ttf -lSDL2_mixer"
+
+cd "$(dirname "$0")/.."
+mkdir -p build
+cd build
+c++ $BenchCompilerFlags ../project/code/bench.cpp -o bench $BenchLinkerFlags
+
+# Headless rendering scenarios, JSON on stdout or to -o <file>
+c++ $BenchCompilerFlags ../project/code/render_bench.cpp -o render_bench $BenchLinkerFlags
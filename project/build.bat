@@ -23,4 +23,8 @@ REM 32-bit build
 REM cl  %CommonCompilerFlags% ..\project\code\main.cpp /link -subsystem:windows,5.1 %CommonLinkerFlags%
 REM 64-bit build
 cl  %CommonCompilerFlags% ..\project\code\main.cpp /link %CommonLinkerFlags%
+
+REM Sound bank packer, then pack the effects at the balanced profile's spec
+cl  %CommonCompilerFlags% ..\project\code\bankpack.cpp /link %CommonLinkerFlags:/SUBSYSTEM:WINDOWS=/SUBSYSTEM:CONSOLE%
+bankpack.exe sounds.bank 48000 2 scratch=wololo.wav
 popd
\ No newline at end of file
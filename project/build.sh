@@ -0,0 +1,14 @@
+#!/bin/sh
+# Linux/macOS build, needs SDL2, SDL2_image, SDL2_ttf and SDL2_mixer development packages.
+
+CommonCompilerFlags="-g -O0 -Wall -Wno-unused-parameter -DHANDMADE_INTERNAL=1 -DHANDMADE_SLOW=1 $(sdl2-config --cflags)"
+CommonLinkerFlags="$(sdl2-config --libs) -lSDL2_image -lSDL2_ttf -lSDL2_mixer"
+
+cd "$(dirname "$0")/.."
+mkdir -p build
+cd build
+c++ $CommonCompilerFlags ../project/code/main.cpp -o main $CommonLinkerFlags
+
+# Sound bank packer, then pack the effects at the balanced profile's spec
+c++ $CommonCompilerFlags ../project/code/bankpack.cpp -o bankpack $CommonLinkerFlags
+./bankpack sounds.bank 48000 2 scratch=wololo.wav
@@ -0,0 +1,74 @@
+#include "actions.h"
+
+InputActions::InputActions()
+{
+    for (int i = 0; i < SDL_NUM_SCANCODES; i++)
+    {
+        mBindings[i] = -1;
+    }
+    for (int i = 0; i < INPUT_ACTION_MAX; i++)
+    {
+        mHeld[i] = 0;
+    }
+    mPressed = 0;
+    mReleased = 0;
+}
+
+void InputActions::bind(int action, SDL_Scancode key)
+{
+    if (action < 0 || action >= INPUT_ACTION_MAX || key < 0 || key >= SDL_NUM_SCANCODES)
+    {
+        return;
+    }
+    mBindings[key] = (Sint8) action;
+}
+
+void InputActions::handleEvent(SDL_Event* e, void* userdata)
+{
+    InputActions* actions = (InputActions*) userdata;
+    if ((e->type == SDL_KEYDOWN || e->type == SDL_KEYUP) && !e->key.repeat)
+    {
+        actions->onKey(e->key.keysym.scancode, e->type == SDL_KEYDOWN);
+    }
+}
+
+void InputActions::onKey(SDL_Scancode key, bool down)
+{
+    if (key < 0 || key >= SDL_NUM_SCANCODES || mBindings[key] < 0)
+    {
+        return;
+    }
+
+    // With several keys on one action only the first down and the last up
+    // are edges
+    int action = mBindings[key];
+    if (down)
+    {
+        if (mHeld[action]++ == 0)
+        {
+            mPressed |= 1u << action;
+        }
+    } else if (mHeld[action] > 0) {
+        if (--mHeld[action] == 0)
+        {
+            mReleased |= 1u << action;
+        }
+    }
+}
+
+bool InputActions::isDown(int action) const {
+    return mHeld[action] > 0;
+}
+
+bool InputActions::wasPressed(int action) const {
+    return (mPressed & (1u << action)) != 0;
+}
+
+bool InputActions::wasReleased(int action) const {
+    return (mReleased & (1u << action)) != 0;
+}
+
+void InputActions::endFrame(){
+    mPressed = 0;
+    mReleased = 0;
+}
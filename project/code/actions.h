@@ -0,0 +1,40 @@
+#ifndef ACTIONS_H
+#define ACTIONS_H
+
+#include "SDL.h"
+
+const int INPUT_ACTION_MAX = 32;
+
+// Maps keys to numbered actions and turns key events into held state plus
+// pressed/released edges for the current frame. Built from events rather
+// than SDL_GetKeyboardState so a tap that starts and ends between two
+// frames still counts as one press. Key repeats are ignored.
+class InputActions
+{
+    public:
+        InputActions();
+
+        // One action per key, several keys may share an action.
+        void bind(int action, SDL_Scancode key);
+
+        // InputHandler for SDL_KEYDOWN..SDL_KEYUP, userdata is the InputActions.
+        static void handleEvent(SDL_Event* e, void* userdata);
+
+        bool isDown(int action) const;
+        bool wasPressed(int action) const;
+        bool wasReleased(int action) const;
+
+        // Clears this frame's edges, call once the frame has used them.
+        void endFrame();
+
+    private:
+        void onKey(SDL_Scancode key, bool down);
+
+        Sint8 mBindings[SDL_NUM_SCANCODES];
+        // Keys of an action currently held
+        Uint8 mHeld[INPUT_ACTION_MAX];
+        Uint32 mPressed;
+        Uint32 mReleased;
+};
+
+#endif
@@ -0,0 +1,228 @@
+#include "alloc_tracker.h"
+
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* gAllocSubsystemNames[ALLOC_SUBSYSTEM_TOTAL] = {
+    "other", "input", "loader", "audio", "render", "text", "workers"
+};
+
+const char* getAllocSubsystemName(AllocSubsystem subsystem){
+    return gAllocSubsystemNames[subsystem];
+}
+
+#if ALLOC_TRACKING_ENABLED
+
+// Counters are bumped from every thread; the rest is main thread only
+static SDL_atomic_t gAllocCounts[ALLOC_SUBSYSTEM_TOTAL];
+static SDL_atomic_t gAllocBytes[ALLOC_SUBSYSTEM_TOTAL];
+static SDL_threadID gAllocMainThread = 0;
+static int gAllocSubsystem = ALLOC_SUBSYSTEM_OTHER;
+
+static Uint32 gFrameStartCounts[ALLOC_SUBSYSTEM_TOTAL];
+static Uint32 gFrameStartBytes[ALLOC_SUBSYSTEM_TOTAL];
+static AllocFrameStats gLastFrame;
+static int gAllocBudget = -1;
+static bool gAllocSteady = false;
+static bool gAllocSteadyNext = false;
+static int gAllocFrames = 0;
+static int gAllocSteadyFrames = 0;
+static int gAllocFramesOverBudget = 0;
+static int gAllocWorstFrame = 0;
+static Uint64 gAllocSteadyTotal = 0;
+
+static inline void countAllocation(size_t size)
+{
+    int subsystem = ALLOC_SUBSYSTEM_WORKERS;
+    if (gAllocMainThread == 0 || SDL_ThreadID() == gAllocMainThread)
+    {
+        subsystem = gAllocSubsystem;
+    }
+    SDL_AtomicAdd(&gAllocCounts[subsystem], 1);
+    SDL_AtomicAdd(&gAllocBytes[subsystem], (int) size);
+}
+
+void* operator new(size_t size)
+{
+    countAllocation(size);
+    void* p = malloc(size > 0 ? size : 1);
+    if (p == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) throw()
+{
+    free(p);
+}
+
+static SDL_malloc_func gSdlMalloc;
+static SDL_calloc_func gSdlCalloc;
+static SDL_realloc_func gSdlRealloc;
+static SDL_free_func gSdlFree;
+
+static void* SDLCALL countingMalloc(size_t size)
+{
+    countAllocation(size);
+    return gSdlMalloc(size);
+}
+
+static void* SDLCALL countingCalloc(size_t count, size_t size)
+{
+    countAllocation(count * size);
+    return gSdlCalloc(count, size);
+}
+
+static void* SDLCALL countingRealloc(void* p, size_t size)
+{
+    countAllocation(size);
+    return gSdlRealloc(p, size);
+}
+
+static void SDLCALL countingFree(void* p)
+{
+    gSdlFree(p);
+}
+
+AllocScope::AllocScope(AllocSubsystem subsystem)
+{
+    mPrevious = gAllocSubsystem;
+    if (gAllocMainThread == 0 || SDL_ThreadID() == gAllocMainThread)
+    {
+        gAllocSubsystem = subsystem;
+    }
+}
+
+AllocScope::~AllocScope()
+{
+    if (gAllocMainThread == 0 || SDL_ThreadID() == gAllocMainThread)
+    {
+        gAllocSubsystem = mPrevious;
+    }
+}
+
+void installAllocTracking()
+{
+    gAllocMainThread = SDL_ThreadID();
+    SDL_GetMemoryFunctions(&gSdlMalloc, &gSdlCalloc, &gSdlRealloc, &gSdlFree);
+    SDL_SetMemoryFunctions(countingMalloc, countingCalloc, countingRealloc, countingFree);
+}
+
+void allocEndFrame()
+{
+    AllocFrameStats& frame = gLastFrame;
+    frame.allocations = 0;
+    frame.bytes = 0;
+    for (int i = 0; i < ALLOC_SUBSYSTEM_TOTAL; i++)
+    {
+        Uint32 count = (Uint32) SDL_AtomicGet(&gAllocCounts[i]);
+        Uint32 bytes = (Uint32) SDL_AtomicGet(&gAllocBytes[i]);
+        frame.subsystemAllocations[i] = (int) (count - gFrameStartCounts[i]);
+        frame.subsystemBytes[i] = bytes - gFrameStartBytes[i];
+        gFrameStartCounts[i] = count;
+        gFrameStartBytes[i] = bytes;
+        if (i != ALLOC_SUBSYSTEM_WORKERS)
+        {
+            frame.allocations += frame.subsystemAllocations[i];
+            frame.bytes += frame.subsystemBytes[i];
+        }
+    }
+    gAllocFrames++;
+
+    bool steady = gAllocSteady;
+    gAllocSteady = gAllocSteadyNext;
+    if (!steady)
+    {
+        return;
+    }
+    gAllocSteadyFrames++;
+    gAllocSteadyTotal += frame.allocations;
+    if (frame.allocations > gAllocWorstFrame)
+    {
+        gAllocWorstFrame = frame.allocations;
+    }
+    if (gAllocBudget >= 0 && frame.allocations > gAllocBudget)
+    {
+        gAllocFramesOverBudget++;
+        printf("frame %d: %d allocations (%u bytes) over a budget of %d:", gAllocFrames, frame.allocations,
+            (unsigned) frame.bytes, gAllocBudget);
+        for (int i = 0; i < ALLOC_SUBSYSTEM_TOTAL; i++)
+        {
+            if (i != ALLOC_SUBSYSTEM_WORKERS && frame.subsystemAllocations[i] > 0)
+            {
+                printf(" %s %d", gAllocSubsystemNames[i], frame.subsystemAllocations[i]);
+            }
+        }
+        printf("\n");
+        SDL_assert(frame.allocations <= gAllocBudget);
+    }
+}
+
+void getAllocFrameStats(AllocFrameStats* stats){
+    *stats = gLastFrame;
+}
+
+void setAllocFrameBudget(int allocations){
+    gAllocBudget = allocations;
+}
+
+void setAllocSteadyState(bool steady){
+    gAllocSteadyNext = steady;
+}
+
+void getAllocTotals(Uint32* allocations, Uint32* bytes)
+{
+    Uint32 count = 0;
+    Uint32 total = 0;
+    for (int i = 0; i < ALLOC_SUBSYSTEM_TOTAL; i++)
+    {
+        count += (Uint32) SDL_AtomicGet(&gAllocCounts[i]);
+        total += (Uint32) SDL_AtomicGet(&gAllocBytes[i]);
+    }
+    *allocations = count;
+    *bytes = total;
+}
+
+void printAllocStats()
+{
+    printf("allocations: %d steady frames, %.2f per frame, worst %d, %d over budget\n", gAllocSteadyFrames,
+        gAllocSteadyFrames > 0 ? (double) gAllocSteadyTotal / gAllocSteadyFrames : 0.0, gAllocWorstFrame, gAllocFramesOverBudget);
+    printf("  since start:");
+    for (int i = 0; i < ALLOC_SUBSYSTEM_TOTAL; i++)
+    {
+        printf(" %s %d", gAllocSubsystemNames[i], SDL_AtomicGet(&gAllocCounts[i]));
+    }
+    printf("\n");
+}
+
+#else
+
+void installAllocTracking(){
+}
+
+void allocEndFrame(){
+}
+
+void getAllocFrameStats(AllocFrameStats* stats){
+    memset(stats, 0, sizeof(*stats));
+}
+
+void setAllocFrameBudget(int allocations){
+}
+
+void setAllocSteadyState(bool steady){
+}
+
+void getAllocTotals(Uint32* allocations, Uint32* bytes){
+    *allocations = 0;
+    *bytes = 0;
+}
+
+void printAllocStats(){
+}
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#include "SDL.h"
+
+#include <stddef.h>
+
+// Counts every operator new and every SDL allocation, per frame and per
+// subsystem, so steady-state frames can be driven to zero allocations.
+// Main thread allocations go to the subsystem of the innermost ALLOC_SCOPE,
+// everything other threads allocate is counted as workers and is not part
+// of the frame. SDL_image, SDL_ttf and SDL_mixer call malloc directly and
+// are not seen. On in internal builds like the profiler, override with
+// -DALLOC_TRACKING_ENABLED=0 or 1.
+#ifndef ALLOC_TRACKING_ENABLED
+#if defined(HANDMADE_INTERNAL) && HANDMADE_INTERNAL
+#define ALLOC_TRACKING_ENABLED 1
+#else
+#define ALLOC_TRACKING_ENABLED 0
+#endif
+#endif
+
+enum AllocSubsystem
+{
+    ALLOC_SUBSYSTEM_OTHER = 0,
+    ALLOC_SUBSYSTEM_INPUT = 1,
+    ALLOC_SUBSYSTEM_LOADER = 2,
+    ALLOC_SUBSYSTEM_AUDIO = 3,
+    ALLOC_SUBSYSTEM_RENDER = 4,
+    ALLOC_SUBSYSTEM_TEXT = 5,
+    ALLOC_SUBSYSTEM_WORKERS = 6,
+    ALLOC_SUBSYSTEM_TOTAL = 7
+};
+
+const char* getAllocSubsystemName(AllocSubsystem subsystem);
+
+#if ALLOC_TRACKING_ENABLED
+
+class AllocScope
+{
+    public:
+        explicit AllocScope(AllocSubsystem subsystem);
+        ~AllocScope();
+
+    private:
+        AllocScope(const AllocScope&);
+        AllocScope& operator=(const AllocScope&);
+
+        int mPrevious;
+};
+
+#define ALLOC_JOIN2(a, b) a##b
+#define ALLOC_JOIN(a, b) ALLOC_JOIN2(a, b)
+#define ALLOC_SCOPE(subsystem) AllocScope ALLOC_JOIN(allocScope, __LINE__)(subsystem)
+
+#else
+
+#define ALLOC_SCOPE(subsystem)
+
+#endif
+
+// Routes SDL's allocator through the counters and makes the calling thread
+// the main thread. Must run before anything calls into SDL.
+void installAllocTracking();
+
+struct AllocFrameStats
+{
+    int allocations;
+    size_t bytes;
+    int subsystemAllocations[ALLOC_SUBSYSTEM_TOTAL];
+    size_t subsystemBytes[ALLOC_SUBSYSTEM_TOTAL];
+};
+
+// Closes the main thread's frame. Once steady, a frame with more
+// allocations than the budget is reported and trips SDL_assert.
+void allocEndFrame();
+void getAllocFrameStats(AllocFrameStats* stats);
+
+// -1 turns the check off, which is the default.
+void setAllocFrameBudget(int allocations);
+// Loading and warm-up frames allocate by design, the budget only applies
+// from the frame after this is set.
+void setAllocSteadyState(bool steady);
+
+// Running totals over all threads for benchmarks to take deltas of. Both
+// wrap, subtract them as unsigned.
+void getAllocTotals(Uint32* allocations, Uint32* bytes);
+
+void printAllocStats();
+
+#endif
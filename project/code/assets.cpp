@@ -0,0 +1,155 @@
+#include "assets.h"
+
+#include <stdio.h>
+
+AssetCache::AssetCache()
+{
+    mImageReuses = 0;
+}
+
+AssetCache::~AssetCache()
+{
+    clear();
+}
+
+SDL_Surface* AssetCache::acquireImage(const std::string& path)
+{
+    std::map<std::string, SDL_Surface*>::iterator it = mImages.find(path);
+    if (it != mImages.end())
+    {
+        mImageReuses++;
+        it->second->refcount++;
+        return it->second;
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    SDL_Surface* surface = IMG_Load(path.c_str());
+    if (surface == NULL)
+    {
+        printf("Unable to load image at %s, Error: %s\n", path.c_str(), IMG_GetError());
+        return NULL;
+    }
+    addTiming(path, ASSET_IMAGE, start);
+
+    // The cache keeps the reference IMG_Load handed out
+    mImages[path] = surface;
+    surface->refcount++;
+    return surface;
+}
+
+void AssetCache::releaseImage(SDL_Surface* surface){
+    SDL_FreeSurface(surface);
+}
+
+SDL_Surface* AssetCache::adoptImage(const std::string& path, SDL_Surface* surface, double decodeMs)
+{
+    std::map<std::string, SDL_Surface*>::iterator it = mImages.find(path);
+    if (it != mImages.end())
+    {
+        SDL_FreeSurface(surface);
+        return it->second;
+    }
+
+    recordTiming(path, ASSET_IMAGE, decodeMs);
+    mImages[path] = surface;
+    return surface;
+}
+
+TTF_Font* AssetCache::loadFont(const std::string& path, int ptsize)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    TTF_Font* font = TTF_OpenFont(path.c_str(), ptsize);
+    if (font != NULL)
+    {
+        addTiming(path, ASSET_FONT, start);
+    }
+    return font;
+}
+
+Mix_Chunk* AssetCache::loadChunk(const std::string& path)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    Mix_Chunk* chunk = Mix_LoadWAV(path.c_str());
+    if (chunk != NULL)
+    {
+        addTiming(path, ASSET_CHUNK, start);
+    }
+    return chunk;
+}
+
+void AssetCache::purgeUnusedImages()
+{
+    std::map<std::string, SDL_Surface*>::iterator it = mImages.begin();
+    while (it != mImages.end())
+    {
+        if (it->second->refcount == 1)
+        {
+            SDL_FreeSurface(it->second);
+            mImages.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void AssetCache::clear()
+{
+    std::map<std::string, SDL_Surface*>::iterator it;
+    for (it = mImages.begin(); it != mImages.end(); ++it)
+    {
+        SDL_FreeSurface(it->second);
+    }
+    mImages.clear();
+}
+
+void AssetCache::addTiming(const std::string& path, AssetType type, Uint64 start)
+{
+    recordTiming(path, type, (double) (SDL_GetPerformanceCounter() - start) * 1000.0 / (double) SDL_GetPerformanceFrequency());
+}
+
+void AssetCache::recordTiming(const std::string& path, AssetType type, double loadMs)
+{
+    AssetTiming timing;
+    timing.path = path;
+    timing.type = type;
+    timing.loadMs = loadMs;
+    mTimings.push_back(timing);
+}
+
+const std::vector<AssetTiming>& AssetCache::getTimings() const {
+    return mTimings;
+}
+
+int AssetCache::getImageReuseCount() const {
+    return mImageReuses;
+}
+
+void AssetCache::printTimings() const
+{
+    double total = 0.0;
+    for (size_t i = 0; i < mTimings.size(); i++)
+    {
+        const AssetTiming& t = mTimings[i];
+        printf("asset %-6s %8.3f ms  %s\n", getAssetTypeName(t.type), t.loadMs, t.path.c_str());
+        total += t.loadMs;
+    }
+    printf("assets: %d loads, %d image decodes reused, %.3f ms total\n", (int) mTimings.size(), mImageReuses, total);
+}
+
+const char* getAssetTypeName(AssetType type)
+{
+    switch (type)
+    {
+    case ASSET_IMAGE:
+    return "image";
+
+    case ASSET_FONT:
+    return "font";
+
+    case ASSET_CHUNK:
+    return "chunk";
+
+    default:
+    return "unknown";
+    }
+}
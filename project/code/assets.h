@@ -0,0 +1,70 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include "SDL.h"
+#include "SDL_image.h"
+#include "SDL_ttf.h"
+#include "SDL_mixer.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+enum AssetType
+{
+    ASSET_IMAGE = 0,
+    ASSET_FONT = 1,
+    ASSET_CHUNK = 2,
+    ASSET_TYPE_TOTAL = 3
+};
+
+struct AssetTiming
+{
+    std::string path;
+    AssetType type;
+    double loadMs;
+};
+
+// Asset loading stage. Images are decoded once and the surface is retained
+// and shared through SDL_Surface's own refcount, so the texture upload, the
+// shape mask and anything else that needs pixels all read the same decode.
+// Every load is timed.
+class AssetCache
+{
+    public:
+        AssetCache();
+        ~AssetCache();
+
+        // Returns a new reference, pair every call with releaseImage().
+        SDL_Surface* acquireImage(const std::string& path);
+        void releaseImage(SDL_Surface* surface);
+
+        // Takes ownership of a surface decoded elsewhere, e.g. on a loader
+        // thread. Returns the surface now cached under path, which is the
+        // older one if path was already loaded.
+        SDL_Surface* adoptImage(const std::string& path, SDL_Surface* surface, double decodeMs);
+
+        // Fonts and chunks are only timed, the caller owns them.
+        TTF_Font* loadFont(const std::string& path, int ptsize);
+        Mix_Chunk* loadChunk(const std::string& path);
+
+        // Drops the cache's reference to images nobody else holds.
+        void purgeUnusedImages();
+        void clear();
+
+        void recordTiming(const std::string& path, AssetType type, double loadMs);
+        const std::vector<AssetTiming>& getTimings() const;
+        int getImageReuseCount() const;
+        void printTimings() const;
+
+    private:
+        void addTiming(const std::string& path, AssetType type, Uint64 start);
+
+        std::map<std::string, SDL_Surface*> mImages;
+        std::vector<AssetTiming> mTimings;
+        int mImageReuses;
+};
+
+const char* getAssetTypeName(AssetType type);
+
+#endif
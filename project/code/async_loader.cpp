@@ -0,0 +1,275 @@
+#include "async_loader.h"
+#include "profiler.h"
+#include "alloc_tracker.h"
+
+#include <stdio.h>
+
+static const int ASYNC_QUEUE_CAPACITY = 256;
+static const int ASYNC_MAX_WORKERS = 4;
+
+AsyncLoader::AsyncLoader()
+    : mJobs(ASYNC_QUEUE_CAPACITY), mDone(ASYNC_QUEUE_CAPACITY)
+{
+    mAssets = NULL;
+    mJobsReady = NULL;
+    mFontLock = NULL;
+    SDL_AtomicSet(&mQuit, 0);
+    SDL_AtomicSet(&mPending, 0);
+    mWakeEvent = 0;
+}
+
+AsyncLoader::~AsyncLoader()
+{
+    stop();
+}
+
+bool AsyncLoader::start(AssetCache* assets, int workers)
+{
+    mAssets = assets;
+    if (workers <= 0)
+    {
+        workers = SDL_GetCPUCount() - 1;
+    }
+    if (workers < 1)
+    {
+        workers = 1;
+    }
+    if (workers > ASYNC_MAX_WORKERS)
+    {
+        workers = ASYNC_MAX_WORKERS;
+    }
+
+    mJobsReady = SDL_CreateSemaphore(0);
+    mFontLock = SDL_CreateMutex();
+    if (mJobsReady == NULL || mFontLock == NULL)
+    {
+        printf("Unable to create loader sync objects, Error: %s\n", SDL_GetError());
+        return false;
+    }
+
+    SDL_AtomicSet(&mQuit, 0);
+    for (int i = 0; i < workers; i++)
+    {
+        SDL_Thread* thread = SDL_CreateThread(workerMain, "asset_loader", this);
+        if (thread == NULL)
+        {
+            printf("Unable to create loader thread, Error: %s\n", SDL_GetError());
+            break;
+        }
+        mWorkers.push_back(thread);
+    }
+    return !mWorkers.empty();
+}
+
+void AsyncLoader::stop()
+{
+    SDL_AtomicSet(&mQuit, 1);
+    for (size_t i = 0; i < mWorkers.size(); i++)
+    {
+        SDL_SemPost(mJobsReady);
+    }
+    for (size_t i = 0; i < mWorkers.size(); i++)
+    {
+        SDL_WaitThread(mWorkers[i], NULL);
+    }
+    mWorkers.clear();
+
+    AsyncRequest* request;
+    while (mJobs.pop(&request))
+    {
+        discard(request);
+    }
+    while (mDone.pop(&request))
+    {
+        discard(request);
+    }
+    SDL_AtomicSet(&mPending, 0);
+
+    if (mJobsReady != NULL)
+    {
+        SDL_DestroySemaphore(mJobsReady);
+        mJobsReady = NULL;
+    }
+    if (mFontLock != NULL)
+    {
+        SDL_DestroyMutex(mFontLock);
+        mFontLock = NULL;
+    }
+}
+
+bool AsyncLoader::loadImage(const std::string& path, AsyncLoadCallback callback, void* userdata){
+    return submit(ASSET_IMAGE, path, 0, callback, userdata);
+}
+
+bool AsyncLoader::loadFont(const std::string& path, int ptsize, AsyncLoadCallback callback, void* userdata){
+    return submit(ASSET_FONT, path, ptsize, callback, userdata);
+}
+
+bool AsyncLoader::loadChunk(const std::string& path, AsyncLoadCallback callback, void* userdata){
+    return submit(ASSET_CHUNK, path, 0, callback, userdata);
+}
+
+bool AsyncLoader::submit(AssetType type, const std::string& path, int ptsize, AsyncLoadCallback callback, void* userdata)
+{
+    if (mWorkers.empty())
+    {
+        printf("Loader not started, dropping %s\n", path.c_str());
+        return false;
+    }
+
+    AsyncRequest* request = new AsyncRequest();
+    request->type = type;
+    request->path = path;
+    request->ptsize = ptsize;
+    request->callback = callback;
+    request->userdata = userdata;
+    request->surface = NULL;
+    request->font = NULL;
+    request->chunk = NULL;
+    request->decodeMs = 0.0;
+
+    SDL_AtomicAdd(&mPending, 1);
+    if (!mJobs.push(request))
+    {
+        printf("Loader queue full, dropping %s\n", path.c_str());
+        SDL_AtomicAdd(&mPending, -1);
+        delete request;
+        return false;
+    }
+    SDL_SemPost(mJobsReady);
+    return true;
+}
+
+int AsyncLoader::workerMain(void* data)
+{
+    AsyncLoader* loader = (AsyncLoader*) data;
+    PROFILE_THREAD("asset_loader");
+    for (;;)
+    {
+        SDL_SemWait(loader->mJobsReady);
+        if (SDL_AtomicGet(&loader->mQuit))
+        {
+            break;
+        }
+
+        AsyncRequest* request;
+        if (loader->mJobs.pop(&request))
+        {
+            {
+                PROFILE_SCOPE("decode");
+                loader->decode(request);
+            }
+            // Only full if the render thread stopped pumping, wait for it
+            while (!loader->mDone.push(request))
+            {
+                SDL_Delay(1);
+            }
+            loader->postWake();
+        }
+    }
+    return 0;
+}
+
+void AsyncLoader::decode(AsyncRequest* request)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    switch (request->type)
+    {
+    case ASSET_IMAGE:
+    request->surface = IMG_Load_RW(SDL_RWFromFile(request->path.c_str(), "rb"), 1);
+    if (request->surface == NULL)
+    {
+        printf("Unable to load image at %s, Error: %s\n", request->path.c_str(), IMG_GetError());
+    }
+    break;
+
+    case ASSET_FONT:
+    SDL_LockMutex(mFontLock);
+    request->font = TTF_OpenFont(request->path.c_str(), request->ptsize);
+    SDL_UnlockMutex(mFontLock);
+    if (request->font == NULL)
+    {
+        printf("Unable to load font at %s, Error: %s\n", request->path.c_str(), TTF_GetError());
+    }
+    break;
+
+    case ASSET_CHUNK:
+    request->chunk = Mix_LoadWAV_RW(SDL_RWFromFile(request->path.c_str(), "rb"), 1);
+    if (request->chunk == NULL)
+    {
+        printf("Unable to load chunk at %s, Error: %s\n", request->path.c_str(), Mix_GetError());
+    }
+    break;
+
+    default:
+    break;
+    }
+    request->decodeMs = (double) (SDL_GetPerformanceCounter() - start) * 1000.0 / (double) SDL_GetPerformanceFrequency();
+}
+
+void AsyncLoader::discard(AsyncRequest* request)
+{
+    SDL_FreeSurface(request->surface);
+    if (request->font != NULL)
+    {
+        TTF_CloseFont(request->font);
+    }
+    Mix_FreeChunk(request->chunk);
+    delete request;
+}
+
+int AsyncLoader::pump(double budgetMs)
+{
+    PROFILE_SCOPE("loader pump");
+    ALLOC_SCOPE(ALLOC_SUBSYSTEM_LOADER);
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 budget = (Uint64) (budgetMs * (double) SDL_GetPerformanceFrequency() / 1000.0);
+
+    int count = 0;
+    AsyncRequest* request;
+    while (mDone.pop(&request))
+    {
+        if (request->surface != NULL)
+        {
+            request->surface = mAssets->adoptImage(request->path, request->surface, request->decodeMs);
+        } else if (request->font != NULL || request->chunk != NULL) {
+            mAssets->recordTiming(request->path, request->type, request->decodeMs);
+        }
+
+        if (request->callback != NULL)
+        {
+            request->callback(request, request->userdata);
+        }
+        delete request;
+        SDL_AtomicAdd(&mPending, -1);
+        count++;
+
+        if (SDL_GetPerformanceCounter() - start >= budget)
+        {
+            // Results left over have already used up their wake event
+            postWake();
+            break;
+        }
+    }
+    return count;
+}
+
+void AsyncLoader::setWakeEventType(Uint32 type){
+    mWakeEvent = type;
+}
+
+void AsyncLoader::postWake()
+{
+    if (mWakeEvent == 0)
+    {
+        return;
+    }
+    SDL_Event e;
+    SDL_zero(e);
+    e.type = mWakeEvent;
+    SDL_PushEvent(&e);
+}
+
+bool AsyncLoader::isIdle(){
+    return SDL_AtomicGet(&mPending) == 0;
+}
@@ -0,0 +1,88 @@
+#ifndef ASYNC_LOADER_H
+#define ASYNC_LOADER_H
+
+#include "SDL.h"
+#include "SDL_image.h"
+#include "SDL_ttf.h"
+#include "SDL_mixer.h"
+
+#include "assets.h"
+#include "lockfree_queue.h"
+
+#include <string>
+#include <vector>
+
+struct AsyncRequest;
+
+// Runs on the main thread from AsyncLoader::pump(). Decoded images are
+// already in the AssetCache by then; fonts and chunks belong to the callback.
+typedef void (*AsyncLoadCallback)(AsyncRequest* request, void* userdata);
+
+struct AsyncRequest
+{
+    AssetType type;
+    std::string path;
+    int ptsize;
+
+    AsyncLoadCallback callback;
+    void* userdata;
+
+    // Filled in by the worker, NULL on failure
+    SDL_Surface* surface;
+    TTF_Font* font;
+    Mix_Chunk* chunk;
+    double decodeMs;
+};
+
+// Decodes images, fonts and chunks on a pool of worker threads. Requests
+// and results travel through lock-free queues; only the completion callbacks,
+// where textures get created, run on the render thread.
+class AsyncLoader
+{
+    public:
+        AsyncLoader();
+        ~AsyncLoader();
+
+        // workers <= 0 picks one per spare CPU core.
+        bool start(AssetCache* assets, int workers);
+        void stop();
+
+        bool loadImage(const std::string& path, AsyncLoadCallback callback, void* userdata);
+        bool loadFont(const std::string& path, int ptsize, AsyncLoadCallback callback, void* userdata);
+        bool loadChunk(const std::string& path, AsyncLoadCallback callback, void* userdata);
+
+        // Runs completion callbacks until the queue is empty or budgetMs has
+        // passed. Returns the number of callbacks run.
+        int pump(double budgetMs);
+
+        // Nothing queued, decoding or waiting for pump().
+        bool isIdle();
+
+        // Workers push an event of this type whenever a result is ready, so
+        // a main loop blocked in SDL_WaitEvent comes back to pump().
+        void setWakeEventType(Uint32 type);
+
+    private:
+        AsyncLoader(const AsyncLoader&);
+        AsyncLoader& operator=(const AsyncLoader&);
+
+        bool submit(AssetType type, const std::string& path, int ptsize, AsyncLoadCallback callback, void* userdata);
+        void decode(AsyncRequest* request);
+        void discard(AsyncRequest* request);
+        void postWake();
+
+        static int workerMain(void* data);
+
+        AssetCache* mAssets;
+        std::vector<SDL_Thread*> mWorkers;
+        LockFreeQueue<AsyncRequest*> mJobs;
+        LockFreeQueue<AsyncRequest*> mDone;
+        SDL_sem* mJobsReady;
+        // FreeType's library object is shared, font opens must not overlap
+        SDL_mutex* mFontLock;
+        SDL_atomic_t mQuit;
+        SDL_atomic_t mPending;
+        Uint32 mWakeEvent;
+};
+
+#endif
@@ -0,0 +1,332 @@
+#include "audio.h"
+
+#include <stdio.h>
+#include <vector>
+
+struct AudioProfileSettings
+{
+    int frequency;
+    int chunkSize;
+    int allowedChanges;
+};
+
+// Chunk sizes are in sample frames and must be powers of two for some
+// drivers. 2048 at 44.1 kHz is the old fixed setting, about 46 ms.
+static const AudioProfileSettings gAudioProfiles[AUDIO_LATENCY_TOTAL] = {
+    {48000, 256, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE},
+    {48000, 512, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE},
+    {44100, 2048, 0},
+};
+
+static AudioLatencyProfile gAudioProfile = AUDIO_LATENCY_SAFE;
+static int gAudioFrequency = 0;
+static int gAudioChunkSize = 0;
+
+// Performance counter at playChunk() per channel, 0 once it has been mixed.
+// Written by the main thread while the channel is idle, read and cleared
+// by the audio thread.
+static std::vector<Uint64> gTriggerTimes;
+
+struct AudioHook
+{
+    AudioMixFunc func;
+    void* userdata;
+};
+
+static AudioHook* gMusicHook = NULL;
+static AudioHook* gPostMixHook = NULL;
+// Mix_PlayMusic is only heard without a music hook
+static bool gMixerMusic = false;
+
+// Audio thread only
+static Uint64 gMixStart = 0;
+static Uint64 gLastMixEnd = 0;
+
+static SDL_SpinLock gMixerLock = 0;
+static Uint64 gMixerBusy = 0;
+static Uint64 gMixerWall = 0;
+static int gMixerCallbacks = 0;
+
+static SDL_SpinLock gLatencyLock = 0;
+static int gLatencyCount = 0;
+static double gLatencyLastMs = 0.0;
+static double gLatencyTotalMs = 0.0;
+static double gLatencyMaxMs = 0.0;
+
+const char* getAudioLatencyProfileName(AudioLatencyProfile profile)
+{
+    switch (profile)
+    {
+    case AUDIO_LATENCY_LOW:
+    return "low";
+
+    case AUDIO_LATENCY_BALANCED:
+    return "balanced";
+
+    case AUDIO_LATENCY_SAFE:
+    return "safe";
+
+    default:
+    return "unknown";
+    }
+}
+
+bool parseAudioLatencyProfile(const char* name, AudioLatencyProfile* profile)
+{
+    for (int i = 0; i < AUDIO_LATENCY_TOTAL; i++)
+    {
+        if (SDL_strcmp(name, getAudioLatencyProfileName((AudioLatencyProfile) i)) == 0)
+        {
+            *profile = (AudioLatencyProfile) i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void SDLCALL onMixBegin(void* udata, Uint8* stream, int len)
+{
+    gMixStart = SDL_GetPerformanceCounter();
+    AudioHook* hook = (AudioHook*) udata;
+    if (hook != NULL)
+    {
+        hook->func(hook->userdata, stream, len);
+    }
+}
+
+static void SDLCALL onMixEnd(void* udata, Uint8* stream, int len)
+{
+    AudioHook* hook = (AudioHook*) udata;
+    if (hook != NULL)
+    {
+        hook->func(hook->userdata, stream, len);
+    }
+
+    // Without the music hook there is no start, those callbacks only
+    // close the interval
+    Uint64 end = SDL_GetPerformanceCounter();
+    if (gMixStart != 0)
+    {
+        SDL_AtomicLock(&gMixerLock);
+        gMixerBusy += end - gMixStart;
+        if (gLastMixEnd != 0)
+        {
+            gMixerWall += end - gLastMixEnd;
+        }
+        gMixerCallbacks++;
+        SDL_AtomicUnlock(&gMixerLock);
+        gMixStart = 0;
+    }
+    gLastMixEnd = end;
+}
+
+static void updateMusicHook()
+{
+    if (gMusicHook == NULL && gMixerMusic)
+    {
+        Mix_HookMusic(NULL, NULL);
+    } else {
+        Mix_HookMusic(onMixBegin, gMusicHook);
+    }
+}
+
+// The mixer swaps the hook pointer under its audio lock, so once the call
+// returns the old hook is no longer in use and can go.
+void setAudioMusicSource(AudioMixFunc func, void* userdata)
+{
+    AudioHook* hook = NULL;
+    if (func != NULL)
+    {
+        hook = new AudioHook();
+        hook->func = func;
+        hook->userdata = userdata;
+    }
+    AudioHook* previous = gMusicHook;
+    gMusicHook = hook;
+    updateMusicHook();
+    delete previous;
+}
+
+void setAudioMixerMusic(bool enabled)
+{
+    gMixerMusic = enabled;
+    updateMusicHook();
+}
+
+void setAudioPostMix(AudioMixFunc func, void* userdata)
+{
+    AudioHook* hook = NULL;
+    if (func != NULL)
+    {
+        hook = new AudioHook();
+        hook->func = func;
+        hook->userdata = userdata;
+    }
+    Mix_SetPostMix(onMixEnd, hook);
+    delete gPostMixHook;
+    gPostMixHook = hook;
+}
+
+double getMixerLoad()
+{
+    SDL_AtomicLock(&gMixerLock);
+    double load = gMixerWall > 0 ? (double) gMixerBusy / (double) gMixerWall : 0.0;
+    SDL_AtomicUnlock(&gMixerLock);
+    return load;
+}
+
+double getMixerCallbackMs()
+{
+    SDL_AtomicLock(&gMixerLock);
+    double ms = gMixerCallbacks > 0 ? (double) gMixerBusy * 1000.0 / (double) SDL_GetPerformanceFrequency() / gMixerCallbacks : 0.0;
+    SDL_AtomicUnlock(&gMixerLock);
+    return ms;
+}
+
+bool openAudio(AudioLatencyProfile profile)
+{
+    for (int p = profile; p < AUDIO_LATENCY_TOTAL; p++)
+    {
+        const AudioProfileSettings& settings = gAudioProfiles[p];
+        if (Mix_OpenAudioDevice(settings.frequency, MIX_DEFAULT_FORMAT, 2, settings.chunkSize, NULL, settings.allowedChanges) < 0)
+        {
+            printf("Audio profile %s unavailable, Error: %s\n", getAudioLatencyProfileName((AudioLatencyProfile) p), Mix_GetError());
+            continue;
+        }
+
+        Uint16 format;
+        int channels;
+        Mix_QuerySpec(&gAudioFrequency, &format, &channels);
+        gAudioChunkSize = settings.chunkSize;
+        gAudioProfile = (AudioLatencyProfile) p;
+        gTriggerTimes.assign(Mix_AllocateChannels(-1), 0);
+
+        SDL_AtomicLock(&gLatencyLock);
+        gLatencyCount = 0;
+        gLatencyLastMs = 0.0;
+        gLatencyTotalMs = 0.0;
+        gLatencyMaxMs = 0.0;
+        SDL_AtomicUnlock(&gLatencyLock);
+
+        SDL_AtomicLock(&gMixerLock);
+        gMixerBusy = 0;
+        gMixerWall = 0;
+        gMixerCallbacks = 0;
+        SDL_AtomicUnlock(&gMixerLock);
+        gLastMixEnd = 0;
+        updateMusicHook();
+        Mix_SetPostMix(onMixEnd, gPostMixHook);
+
+        printf("Audio: %s profile on %s, %d Hz, %d frames (%.1f ms buffer)\n", getAudioLatencyProfileName(gAudioProfile),
+            SDL_GetCurrentAudioDriver(), gAudioFrequency, gAudioChunkSize, getAudioBufferMs());
+        return true;
+    }
+    return false;
+}
+
+void closeAudio()
+{
+    Mix_CloseAudio();
+    gTriggerTimes.clear();
+    gAudioFrequency = 0;
+    gAudioChunkSize = 0;
+}
+
+AudioLatencyProfile getAudioProfile(){
+    return gAudioProfile;
+}
+
+int getAudioFrequency(){
+    return gAudioFrequency;
+}
+
+int getAudioChunkSize(){
+    return gAudioChunkSize;
+}
+
+double getAudioBufferMs()
+{
+    if (gAudioFrequency == 0)
+    {
+        return 0.0;
+    }
+    return gAudioChunkSize * 1000.0 / gAudioFrequency;
+}
+
+// Runs on the audio thread for every buffer the channel is mixed into.
+static void SDLCALL onChannelMixed(int channel, void* stream, int len, void* udata)
+{
+    Uint64 triggered = gTriggerTimes[channel];
+    if (triggered == 0)
+    {
+        return;
+    }
+    gTriggerTimes[channel] = 0;
+
+    double ms = (double) (SDL_GetPerformanceCounter() - triggered) * 1000.0 / (double) SDL_GetPerformanceFrequency();
+    SDL_AtomicLock(&gLatencyLock);
+    gLatencyCount++;
+    gLatencyLastMs = ms;
+    gLatencyTotalMs += ms;
+    if (ms > gLatencyMaxMs)
+    {
+        gLatencyMaxMs = ms;
+    }
+    SDL_AtomicUnlock(&gLatencyLock);
+}
+
+int playChunk(int channel, Mix_Chunk* chunk, int loops)
+{
+    if (chunk == NULL)
+    {
+        return -1;
+    }
+
+    // Pick the free channel here rather than let Mix_PlayChannel do it, so
+    // the effect is in place before the mixer can first see the chunk.
+    // Mixer effects are dropped when a channel finishes.
+    int count = (int) gTriggerTimes.size();
+    if (channel < 0)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (!Mix_Playing(i) && !Mix_Paused(i))
+            {
+                channel = i;
+                break;
+            }
+        }
+        if (channel < 0)
+        {
+            return Mix_PlayChannel(-1, chunk, loops);
+        }
+    }
+    if (channel >= count)
+    {
+        return Mix_PlayChannel(channel, chunk, loops);
+    }
+
+    Mix_HaltChannel(channel);
+    gTriggerTimes[channel] = SDL_GetPerformanceCounter();
+    Mix_RegisterEffect(channel, onChannelMixed, NULL, NULL);
+    return Mix_PlayChannel(channel, chunk, loops);
+}
+
+void getAudioLatencyStats(AudioLatencyStats* stats)
+{
+    SDL_AtomicLock(&gLatencyLock);
+    stats->count = gLatencyCount;
+    stats->lastMs = gLatencyLastMs;
+    stats->averageMs = gLatencyCount > 0 ? gLatencyTotalMs / gLatencyCount : 0.0;
+    stats->maxMs = gLatencyMaxMs;
+    SDL_AtomicUnlock(&gLatencyLock);
+}
+
+void printAudioStats()
+{
+    AudioLatencyStats stats;
+    getAudioLatencyStats(&stats);
+    printf("audio: %s profile, %.1f ms buffer, %d triggers, trigger to mix %.2f ms avg, %.2f ms max\n",
+        getAudioLatencyProfileName(gAudioProfile), getAudioBufferMs(), stats.count, stats.averageMs, stats.maxMs);
+    printf("  mixer %.3f ms per callback, %.2f%% of the audio thread\n", getMixerCallbackMs(), getMixerLoad() * 100.0);
+}
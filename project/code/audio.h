@@ -0,0 +1,69 @@
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include "SDL.h"
+#include "SDL_mixer.h"
+
+// How much output buffering to trade for click-to-sound latency. Each
+// profile asks for a smaller device buffer than the next.
+enum AudioLatencyProfile
+{
+    AUDIO_LATENCY_LOW = 0,
+    AUDIO_LATENCY_BALANCED = 1,
+    AUDIO_LATENCY_SAFE = 2,
+    AUDIO_LATENCY_TOTAL = 3
+};
+
+const char* getAudioLatencyProfileName(AudioLatencyProfile profile);
+bool parseAudioLatencyProfile(const char* name, AudioLatencyProfile* profile);
+
+// Opens the mixer for profile. The faster profiles let the device keep its
+// own sample rate so SDL doesn't add a resampling stage; when the device
+// refuses the buffer size the next safer profile is tried.
+bool openAudio(AudioLatencyProfile profile);
+void closeAudio();
+
+AudioLatencyProfile getAudioProfile();
+int getAudioFrequency();
+int getAudioChunkSize();
+// Length of one device buffer, the floor on output latency.
+double getAudioBufferMs();
+
+// Mix_PlayChannel that remembers when it was called. The time until the
+// mixer first pulls the chunk into a buffer is measured on the audio thread.
+int playChunk(int channel, Mix_Chunk* chunk, int loops);
+
+struct AudioLatencyStats
+{
+    int count;
+    double lastMs;
+    double averageMs;
+    double maxMs;
+};
+
+// Trigger to mix latency over every playChunk() since openAudio().
+void getAudioLatencyStats(AudioLatencyStats* stats);
+
+typedef void (*AudioMixFunc)(void* userdata, Uint8* stream, int len);
+
+// openAudio() takes over Mix_HookMusic and Mix_SetPostMix to time the mixer,
+// other modules hook in here instead. The music source runs first in each
+// callback on a silent stream, before the channels are mixed; Mix_PlayMusic
+// is not heard while the hook is installed. The post mix runs after them.
+// Both run on the audio thread, pass NULL to remove.
+void setAudioMusicSource(AudioMixFunc func, void* userdata);
+void setAudioPostMix(AudioMixFunc func, void* userdata);
+
+// Call with true before Mix_PlayMusic. Unless a music source is set, the
+// music hook is then taken out so SDL_mixer mixes its Mix_Music, and the
+// mixer load below is not measured until this is turned off again.
+void setAudioMixerMusic(bool enabled);
+
+// Share of audio thread time spent in the mixer callback, 0 to 1, and the
+// average callback cost.
+double getMixerLoad();
+double getMixerCallbackMs();
+
+void printAudioStats();
+
+#endif
@@ -0,0 +1,64 @@
+// Packs WAV files into a sound bank for the game to map at startup.
+//
+//   bankpack <out.bank> <frequency> <channels> name=file.wav ...
+//
+// The spec must match what the mixer ends up running at, see Mix_QuerySpec,
+// or the game ignores the bank and loads the loose files.
+#include "SDL.h"
+#include "SDL_mixer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "crc32.cpp"
+#include "mapped_file.cpp"
+#include "sound_bank.cpp"
+
+int main(int argc, char* args[])
+{
+    if (argc < 5)
+    {
+        printf("usage: bankpack <out.bank> <frequency> <channels> name=file.wav ...\n");
+        return 1;
+    }
+
+    int frequency = atoi(args[2]);
+    int channels = atoi(args[3]);
+    if (frequency <= 0 || channels <= 0 || channels > 8)
+    {
+        printf("bad spec %s Hz, %s channels\n", args[2], args[3]);
+        return 1;
+    }
+
+    std::vector<std::string> names;
+    std::vector<std::string> files;
+    for (int i = 4; i < argc; i++)
+    {
+        const char* split = strchr(args[i], '=');
+        if (split == NULL || split == args[i])
+        {
+            printf("expected name=file.wav, got %s\n", args[i]);
+            return 1;
+        }
+        names.push_back(std::string(args[i], split - args[i]));
+        files.push_back(split + 1);
+    }
+
+    if (SDL_Init(0) < 0)
+    {
+        printf("error initializing: %s\n", SDL_GetError());
+        return 1;
+    }
+    bool success = writeSoundBank(args[1], names, files, frequency, MIX_DEFAULT_FORMAT, channels);
+    SDL_Quit();
+    if (!success)
+    {
+        return 1;
+    }
+
+    printf("%s: %d sounds at %d Hz, %d channels\n", args[1], (int) names.size(), frequency, channels);
+    return 0;
+}
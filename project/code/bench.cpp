@@ -0,0 +1,1105 @@
+#include "SDL.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "profiler.cpp"
+#include "alloc_tracker.cpp"
+#include "frame_arena.cpp"
+#include "color_key_scan.cpp"
+#include "shape_mask.cpp"
+#include "sprite_atlas.cpp"
+#include "sprite_batch.cpp"
+#include "render_queue.cpp"
+#include "assets.cpp"
+#include "texture_cache.cpp"
+#include "ltexture.cpp"
+#include "glyph_cache.cpp"
+#include "damage.cpp"
+#include "hit_grid.cpp"
+#include "audio.cpp"
+#include "mix_kernels.cpp"
+#include "soft_mixer.cpp"
+#include "crc32.cpp"
+#include "mapped_file.cpp"
+#include "sound_bank.cpp"
+#include "music_stream.cpp"
+
+SDL_Renderer* sdlRenderer = NULL;
+AssetCache gAssets;
+TextureCache gTextureCache;
+TTF_Font* gFont = NULL;
+
+static const int BUTTON_STATES = 4;
+
+static double secondsSince(Uint64 start)
+{
+    return (double) (SDL_GetPerformanceCounter() - start) / (double) SDL_GetPerformanceFrequency();
+}
+
+// Skin-like test image: a filled circle on a key colored background.
+static void makeSkin(std::vector<Uint32>& pixels, int width, int height, Uint32 key)
+{
+    pixels.resize(width * height);
+    int cx = width / 2;
+    int cy = height / 2;
+    int r = (width < height ? width : height) / 2 - 1;
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            int dx = x - cx;
+            int dy = y - cy;
+            pixels[y * width + x] = (dx * dx + dy * dy <= r * r) ? 0x00336699 : key;
+        }
+    }
+}
+
+// Scans every row of a skin width pixels wide with scan and with the scalar
+// path and compares the bits. Widths that aren't a multiple of the vector
+// width run the tail code. Returns the first row that differs, -1 if none.
+static int checkColorKeyScan(ColorKeyScanFunc scan, int width, int height, Uint32 key)
+{
+    ColorKeyScanFunc scalar = getColorKeyScanFunc(COLOR_KEY_SCAN_SCALAR);
+    std::vector<Uint32> pixels;
+    makeSkin(pixels, width, height, key);
+    // Junk in the bits outside the compare mask must not matter
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        pixels[i] |= (Uint32) (i * 2654435761u) & 0xFF000000;
+    }
+    std::vector<Uint8> expected((width + 7) / 8);
+    std::vector<Uint8> bits((width + 7) / 8);
+    for (int y = 0; y < height; y++)
+    {
+        scalar(&pixels[y * width], width, key, 0x00FFFFFF, &expected[0]);
+        scan(&pixels[y * width], width, key, 0x00FFFFFF, &bits[0]);
+        for (int x = 0; x < width; x++)
+        {
+            if (((expected[x / 8] >> (x % 8)) & 1) != ((bits[x / 8] >> (x % 8)) & 1))
+            {
+                return y;
+            }
+        }
+    }
+    return -1;
+}
+
+static void benchColorKeyScan()
+{
+    const int width = 1920;
+    const int height = 1080;
+    const int iterations = 200;
+    const Uint32 key = 0x0000FFFF;
+
+    std::vector<Uint32> pixels;
+    makeSkin(pixels, width, height, key);
+    std::vector<Uint8> bits((width + 7) / 8);
+
+    printf("color_key_scan %dx%d, selected path: %s\n", width, height, getColorKeyScanPathName(selectColorKeyScanPath()));
+    for (int path = 0; path < COLOR_KEY_SCAN_TOTAL; path++)
+    {
+        ColorKeyScanFunc scan = getColorKeyScanFunc((ColorKeyScanPath) path);
+        if (scan == NULL || (path == COLOR_KEY_SCAN_AVX2 && !SDL_HasAVX2()) || (path == COLOR_KEY_SCAN_SSE2 && !SDL_HasSSE2()))
+        {
+            printf("  %-8s unavailable\n", getColorKeyScanPathName((ColorKeyScanPath) path));
+            continue;
+        }
+
+        // Same bits as the scalar path, on the skin and with an odd width
+        const int checkWidths[] = {width, 1919, 47, 5};
+        for (int w = 0; w < 4; w++)
+        {
+            int row = checkColorKeyScan(scan, checkWidths[w], height, key);
+            if (row >= 0)
+            {
+                printf("  %-8s MISMATCH with scalar, width %d row %d\n", getColorKeyScanPathName((ColorKeyScanPath) path), checkWidths[w], row);
+                SDL_assert_release(!"color key scan differs from scalar");
+            }
+        }
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int i = 0; i < iterations; i++)
+        {
+            for (int y = 0; y < height; y++)
+            {
+                scan(&pixels[y * width], width, key, 0x00FFFFFF, &bits[0]);
+            }
+        }
+        double seconds = secondsSince(start);
+        printf("  %-8s %10.1f Mpixels/s\n", getColorKeyScanPathName((ColorKeyScanPath) path), (double) width * height * iterations / seconds / 1e6);
+    }
+
+    ShapeMask mask;
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < iterations / 10; i++)
+    {
+        mask.buildFromPixels(&pixels[0], width, height, width * 4, key, 0x00FFFFFF);
+    }
+    double seconds = secondsSince(start);
+    printf("  shape mask build %10.1f Mpixels/s, %d spans, %d rects\n", (double) width * height * (iterations / 10) / seconds / 1e6, (int) mask.getSpans().size(), (int) mask.getRects().size());
+}
+
+static SDL_Surface* makeButtonSurface(int w, int h, Uint8 r, Uint8 g, Uint8 b)
+{
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_FillRect(surface, NULL, SDL_MapRGBA(surface->format, r, g, b, 0xFF));
+    SDL_Rect inner = {4, 4, w - 8, h - 8};
+    SDL_FillRect(surface, &inner, SDL_MapRGBA(surface->format, r / 2, g / 2, b / 2, 0xC0));
+    return surface;
+}
+
+// 10k button sprites from four loose textures, one SDL_RenderCopy each with
+// its texture state set every time, versus packed into an atlas and
+// submitted through SpriteBatch. Both end in SDL_RenderCopy, so the gap is
+// the batching alone.
+static void benchSpriteBatch()
+{
+    const int sprites = 10000;
+    const int frames = 30;
+    const int buttonSize = 32;
+
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, 1024, 768, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer* renderer = SDL_CreateSoftwareRenderer(target);
+    if (renderer == NULL)
+    {
+        printf("sprite_batch: no software renderer, %s\n", SDL_GetError());
+        SDL_FreeSurface(target);
+        return;
+    }
+
+    SDL_Surface* buttons[BUTTON_STATES];
+    SDL_Texture* loose[BUTTON_STATES];
+    SpriteAtlas atlas;
+    atlas.init(256, 256, 1);
+    for (int i = 0; i < BUTTON_STATES; i++)
+    {
+        buttons[i] = makeButtonSurface(buttonSize, buttonSize, (Uint8) (60 * i), 0x80, (Uint8) (0xFF - 60 * i));
+        loose[i] = SDL_CreateTextureFromSurface(renderer, buttons[i]);
+        atlas.add(buttons[i], NULL);
+    }
+    atlas.upload(renderer);
+
+    std::vector<SDL_Rect> positions(sprites);
+    std::vector<int> states(sprites);
+    for (int i = 0; i < sprites; i++)
+    {
+        positions[i].x = (i * 37) % (1024 - buttonSize);
+        positions[i].y = (i * 53) % (768 - buttonSize);
+        positions[i].w = buttonSize;
+        positions[i].h = buttonSize;
+        states[i] = (i * 7) % BUTTON_STATES;
+    }
+
+    SDL_Rect clip = {0, 0, buttonSize, buttonSize};
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int f = 0; f < frames; f++)
+    {
+        SDL_RenderClear(renderer);
+        for (int i = 0; i < sprites; i++)
+        {
+            SDL_Texture* texture = loose[states[i]];
+            SDL_SetTextureColorMod(texture, 0xFF, 0xFF, 0xFF);
+            SDL_SetTextureAlphaMod(texture, 0xFF);
+            SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+            SDL_RenderCopy(renderer, texture, &clip, &positions[i]);
+        }
+        SDL_RenderPresent(renderer);
+    }
+    double perCall = secondsSince(start);
+
+    SpriteBatch batch;
+    SDL_Color white = {0xFF, 0xFF, 0xFF, 0xFF};
+    start = SDL_GetPerformanceCounter();
+    for (int f = 0; f < frames; f++)
+    {
+        SDL_RenderClear(renderer);
+        for (int i = 0; i < sprites; i++)
+        {
+            batch.draw(atlas.getSprite(states[i]), positions[i].x, positions[i].y, white);
+        }
+        batch.flush(renderer);
+        SDL_RenderPresent(renderer);
+    }
+    double batched = secondsSince(start);
+
+    printf("sprite_batch %d sprites, software renderer, %d atlas page(s)\n", sprites, atlas.getPageCount());
+    printf("  per-call %8.2f ms/frame %10.0f sprites/s\n", perCall * 1000.0 / frames, (double) sprites * frames / perCall);
+    printf("  batched  %8.2f ms/frame %10.0f sprites/s, %d state changes/frame\n", batched * 1000.0 / frames, (double) sprites * frames / batched, batch.getStateChanges());
+
+    atlas.free();
+    for (int i = 0; i < BUTTON_STATES; i++)
+    {
+        SDL_DestroyTexture(loose[i]);
+        SDL_FreeSurface(buttons[i]);
+    }
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(target);
+}
+
+// The three LTexture::render classes on the software renderer, plus the
+// old behaviour of sending unrotated draws through SDL_RenderCopyEx.
+static void benchTextureRender()
+{
+    const int draws = 20000;
+    const int size = 64;
+
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, 1024, 768, 32, SDL_PIXELFORMAT_ARGB8888);
+    sdlRenderer = SDL_CreateSoftwareRenderer(target);
+    if (sdlRenderer == NULL)
+    {
+        printf("texture_render: no software renderer, %s\n", SDL_GetError());
+        SDL_FreeSurface(target);
+        return;
+    }
+
+    SDL_Surface* sprite = makeButtonSurface(size, size, 0x40, 0x80, 0xC0);
+    LTexture texture;
+    texture.loadFromSurface(sprite);
+    texture.setBlendMode(SDL_BLENDMODE_BLEND);
+    SDL_Texture* raw = SDL_CreateTextureFromSurface(sdlRenderer, sprite);
+    SDL_SetTextureBlendMode(raw, SDL_BLENDMODE_BLEND);
+
+    printf("texture_render %d draws of %dx%d, software renderer\n", draws, size, size);
+    resetTextureDrawCounts();
+    for (int mode = 0; mode < 4; mode++)
+    {
+        SDL_RenderClear(sdlRenderer);
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int i = 0; i < draws; i++)
+        {
+            int x = (i * 37) % (1024 - 2 * size);
+            int y = (i * 53) % (768 - 2 * size);
+            SDL_Rect scaled = {x, y, size + size / 2, size + size / 2};
+            SDL_Rect plain = {x, y, size, size};
+            switch (mode)
+            {
+            case 0:
+            texture.render(x, y);
+            break;
+
+            case 1:
+            texture.render(scaled);
+            break;
+
+            case 2:
+            texture.render(x, y, NULL, 15.0);
+            break;
+
+            case 3:
+            SDL_RenderCopyEx(sdlRenderer, raw, NULL, &plain, 0.0, NULL, SDL_FLIP_NONE);
+            break;
+            }
+        }
+        double seconds = secondsSince(start);
+        const char* names[] = {"blit", "scaled", "rotated", "copy_ex"};
+        printf("  %-8s %10.0f draws/s\n", names[mode], draws / seconds);
+    }
+    printf("  counters blit %d, scaled %d, rotated %d\n", getTextureDrawCount(LTEXTURE_DRAW_BLIT),
+        getTextureDrawCount(LTEXTURE_DRAW_SCALED), getTextureDrawCount(LTEXTURE_DRAW_ROTATED));
+
+    texture.free();
+    SDL_DestroyTexture(raw);
+    SDL_FreeSurface(sprite);
+    SDL_DestroyRenderer(sdlRenderer);
+    sdlRenderer = NULL;
+    SDL_FreeSurface(target);
+}
+
+// Per-frame dynamic strings: one TTF surface and texture per string versus
+// quads from the glyph cache. Run from the build directory for the font.
+static void benchTextRender()
+{
+    const int strings = 2000;
+
+    if (TTF_Init() == -1)
+    {
+        printf("text_render: %s\n", TTF_GetError());
+        return;
+    }
+    TTF_Font* font = TTF_OpenFont("OpenSans-Regular.ttf", 28);
+    if (font == NULL)
+    {
+        printf("text_render: %s\n", TTF_GetError());
+        TTF_Quit();
+        return;
+    }
+    gFont = font;
+
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, 1024, 768, 32, SDL_PIXELFORMAT_ARGB8888);
+    sdlRenderer = SDL_CreateSoftwareRenderer(target);
+
+    SDL_Color black = {0, 0, 0, 0xFF};
+    char text[64];
+
+    LTexture texture;
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < strings; i++)
+    {
+        SDL_snprintf(text, sizeof(text), "Milliseconds since start time %d", i * 16);
+        texture.loadFromRenderedText(text, black);
+        texture.render(0, (i * 29) % 700);
+    }
+    double perString = secondsSince(start);
+    texture.free();
+
+    GlyphCache glyphs;
+    Uint64 buildStart = SDL_GetPerformanceCounter();
+    glyphs.build(sdlRenderer, font);
+    double build = secondsSince(buildStart);
+
+    SpriteBatch batch;
+    start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < strings; i++)
+    {
+        SDL_snprintf(text, sizeof(text), "Milliseconds since start time %d", i * 16);
+        glyphs.draw(batch, 0, (i * 29) % 700, text, black);
+        batch.flush(sdlRenderer);
+    }
+    double cached = secondsSince(start);
+
+    printf("text_render %d strings, software renderer\n", strings);
+    printf("  ttf per string %10.0f strings/s\n", strings / perString);
+    printf("  glyph cache    %10.0f strings/s (build %.2f ms)\n", strings / cached, build * 1000.0);
+
+    glyphs.free();
+    SDL_DestroyRenderer(sdlRenderer);
+    sdlRenderer = NULL;
+    SDL_FreeSurface(target);
+    TTF_CloseFont(font);
+    gFont = NULL;
+    TTF_Quit();
+}
+
+struct ButtonGrid
+{
+    LTexture* sheet;
+    SDL_Rect clips[BUTTON_STATES];
+    std::vector<int> states;
+    int columns;
+    int size;
+};
+
+static void drawButtonGrid(const SDL_Rect& area, void* userdata)
+{
+    ButtonGrid* grid = (ButtonGrid*) userdata;
+    SDL_SetRenderDrawColor(sdlRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+    SDL_RenderFillRect(sdlRenderer, &area);
+    for (size_t i = 0; i < grid->states.size(); i++)
+    {
+        int x = (int) (i % grid->columns) * grid->size;
+        int y = (int) (i / grid->columns) * grid->size;
+        grid->sheet->render(x, y, &grid->clips[grid->states[i]]);
+    }
+}
+
+// A window full of buttons where one changes state per frame, as in the
+// overlay: full clear and redraw versus redrawing the damaged rect only.
+static void benchDirtyRects()
+{
+    const int width = 1024;
+    const int height = 768;
+    const int size = 64;
+    const int frames = 300;
+
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+    sdlRenderer = SDL_CreateSoftwareRenderer(target);
+    if (sdlRenderer == NULL)
+    {
+        printf("dirty_rects: no software renderer, %s\n", SDL_GetError());
+        SDL_FreeSurface(target);
+        return;
+    }
+
+    SDL_Surface* sheetSurface = SDL_CreateRGBSurfaceWithFormat(0, size * BUTTON_STATES, size, 32, SDL_PIXELFORMAT_ARGB8888);
+    ButtonGrid grid;
+    for (int i = 0; i < BUTTON_STATES; i++)
+    {
+        SDL_Surface* button = makeButtonSurface(size, size, (Uint8) (60 * i), 0x80, (Uint8) (0xFF - 60 * i));
+        SDL_Rect clip = {i * size, 0, size, size};
+        SDL_BlitSurface(button, NULL, sheetSurface, &clip);
+        SDL_FreeSurface(button);
+        grid.clips[i] = clip;
+    }
+    LTexture sheet;
+    sheet.loadFromSurface(sheetSurface);
+    sheet.setBlendMode(SDL_BLENDMODE_BLEND);
+    grid.sheet = &sheet;
+    grid.columns = width / size;
+    grid.size = size;
+    grid.states.assign(grid.columns * (height / size), 0);
+
+    DamageTracker full;
+    full.init(width, height, false);
+    DamageTracker partial;
+    partial.init(width, height, true);
+    DamageTracker* trackers[] = {&full, &partial};
+    const char* names[] = {"full", "damage"};
+
+    printf("dirty_rects %dx%d, %d buttons, one changing per frame, software renderer\n", width, height, (int) grid.states.size());
+    for (int mode = 0; mode < 2; mode++)
+    {
+        DamageTracker* damage = trackers[mode];
+        resetTextureDrawCounts();
+        Uint64 pixels = 0;
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int f = 0; f < frames; f++)
+        {
+            int changed = (f * 37) % (int) grid.states.size();
+            grid.states[changed] = (grid.states[changed] + 1) % BUTTON_STATES;
+            SDL_Rect area = {(changed % grid.columns) * size, (changed / grid.columns) * size, size, size};
+            damage->add(area);
+
+            damage->redraw(sdlRenderer, drawButtonGrid, &grid);
+            pixels += damage->getRedrawnPixels();
+            damage->clear();
+        }
+        double seconds = secondsSince(start);
+        printf("  %-8s %8.3f ms/frame, %8.0f pixels/frame, %d draws culled\n", names[mode], seconds * 1000.0 / frames,
+            (double) pixels / frames, getTextureDrawCount(LTEXTURE_DRAW_CULLED));
+    }
+
+    sheet.free();
+    SDL_FreeSurface(sheetSurface);
+    SDL_DestroyRenderer(sdlRenderer);
+    sdlRenderer = NULL;
+    SDL_FreeSurface(target);
+}
+
+// Pointer events against N buttons: the old LButton::handleEvent, which
+// asked SDL_GetMouseState and compared against every button in turn, versus
+// one HitGrid lookup on the event coordinates.
+static void benchHitTest()
+{
+    const int width = 1920;
+    const int height = 1080;
+    const int size = 24;
+    const int counts[] = {10, 1000, 100000};
+
+    printf("hit_test %dx%d, %dx%d buttons\n", width, height, size, size);
+    for (int c = 0; c < 3; c++)
+    {
+        int count = counts[c];
+        std::vector<SDL_Rect> bounds(count);
+        HitGrid grid;
+        grid.init(width, height, 32);
+        for (int i = 0; i < count; i++)
+        {
+            SDL_Rect rect = {(int) (((Uint32) i * 2654435761u) % (width - size)), (int) (((Uint32) i * 40503u) % (height - size)), size, size};
+            bounds[i] = rect;
+            grid.add(rect, NULL);
+        }
+
+        const int events = 100000;
+        std::vector<SDL_Point> points(events);
+        for (int i = 0; i < events; i++)
+        {
+            points[i].x = (int) (((Uint32) i * 7919u) % (Uint32) width);
+            points[i].y = (int) (((Uint32) i * 104729u) % (Uint32) height);
+        }
+
+        // Keep the linear run around the same total work at every count
+        int linearEvents = 20000000 / count;
+        if (linearEvents > events)
+        {
+            linearEvents = events;
+        }
+        int linearHits = 0;
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int e = 0; e < linearEvents; e++)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                int x, y;
+                SDL_GetMouseState(&x, &y);
+                x = points[e].x;
+                y = points[e].y;
+                const SDL_Rect& b = bounds[i];
+                if (!(x < b.x || x > b.x + b.w || y < b.y || y > b.y + b.h))
+                {
+                    linearHits++;
+                }
+            }
+        }
+        double linear = secondsSince(start);
+
+        int gridHits = 0;
+        start = SDL_GetPerformanceCounter();
+        for (int e = 0; e < events; e++)
+        {
+            if (grid.hitTest(points[e].x, points[e].y) >= 0)
+            {
+                gridHits++;
+            }
+        }
+        double indexed = secondsSince(start);
+
+        printf("  %6d buttons  linear %12.0f events/s   grid %12.0f events/s  (%d grid hits)\n", count,
+            linearEvents / linear, events / indexed, gridHits);
+        (void) linearHits;
+    }
+}
+
+// Trigger to mix latency for every profile. Runs on the dummy audio driver
+// unless SDL_AUDIODRIVER says otherwise, e.g. disk, which also paces itself
+// like a real device.
+static void benchAudioLatency()
+{
+    const int triggers = 50;
+
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0)
+    {
+        printf("audio_latency: %s\n", SDL_GetError());
+        return;
+    }
+
+    printf("audio_latency %d triggers per profile\n", triggers);
+    for (int p = 0; p < AUDIO_LATENCY_TOTAL; p++)
+    {
+        if (!openAudio((AudioLatencyProfile) p))
+        {
+            continue;
+        }
+
+        // 50 ms of a quiet square wave, already in the output format
+        int frames = getAudioFrequency() / 20;
+        std::vector<Sint16> samples(frames * 2);
+        for (int i = 0; i < frames; i++)
+        {
+            Sint16 value = (i / 50) % 2 ? 2000 : -2000;
+            samples[i * 2] = value;
+            samples[i * 2 + 1] = value;
+        }
+        Mix_Chunk* chunk = Mix_QuickLoad_RAW((Uint8*) &samples[0], (Uint32) (samples.size() * sizeof(Sint16)));
+
+        for (int i = 0; i < triggers; i++)
+        {
+            playChunk(-1, chunk, 0);
+            // Land at different points of the device period
+            SDL_Delay(7 + (i * 13) % 11);
+        }
+        SDL_Delay(100);
+        Mix_HaltChannel(-1);
+
+        AudioLatencyStats stats;
+        getAudioLatencyStats(&stats);
+        printf("  %-8s %5d Hz %5d frames %6.1f ms buffer   trigger to mix %6.2f ms avg %6.2f ms max (%d/%d mixed)\n",
+            getAudioLatencyProfileName(getAudioProfile()), getAudioFrequency(), getAudioChunkSize(), getAudioBufferMs(),
+            stats.averageMs, stats.maxMs, stats.count, triggers);
+
+        Mix_FreeChunk(chunk);
+        closeAudio();
+    }
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+}
+
+static void makeTone(std::vector<Sint16>& samples, int frames, int period)
+{
+    samples.resize(frames * 2);
+    for (int i = 0; i < frames; i++)
+    {
+        Sint16 value = (i / period) % 2 ? 3000 : -3000;
+        samples[i * 2] = value;
+        samples[i * 2 + 1] = (Sint16) -value;
+    }
+}
+
+// Mixes the same voices through path, with ramps and buffer sizes that
+// leave kernel tails, into out.
+static bool renderSoftMixerCheck(MixKernelPath path, const SoftSound* s16, const SoftSound* f32, std::vector<Sint16>& out)
+{
+    const int sizes[] = {1024, 1037, 3, 509, 16, 2048};
+    const int count = (int) (sizeof(sizes) / sizeof(sizes[0]));
+    SoftMixer mixer;
+    if (!mixer.init(48000, 16, path))
+    {
+        return false;
+    }
+    int handles[16];
+    for (int v = 0; v < 16; v++)
+    {
+        handles[v] = mixer.play(v % 2 ? f32 : s16, 0.05f + v * 0.03f, (v % 5) / 2.0f - 1.0f, true);
+    }
+    out.clear();
+    for (int i = 0; i < count; i++)
+    {
+        if (i == 2)
+        {
+            for (int v = 0; v < 16; v += 3)
+            {
+                mixer.setGain(handles[v], 0.7f);
+                mixer.setPan(handles[v], 0.3f);
+            }
+            mixer.stop(handles[1]);
+        }
+        size_t offset = out.size();
+        out.resize(offset + sizes[i] * 2);
+        for (int j = 0; j < sizes[i] * 2; j++)
+        {
+            // Not silent, so the resolve adds and saturates
+            out[offset + j] = (Sint16) ((j * 7919) % 60000 - 30000);
+        }
+        mixer.mix(&out[offset], sizes[i]);
+    }
+    return true;
+}
+
+// Voices mixed per millisecond of CPU: the soft mixer kernels offline, then
+// SDL_mixer channels against the soft mixer in the real audio callback on
+// the dummy driver, timed by the audio module.
+static void benchSoftMixer()
+{
+    const int voices = 64;
+    const int frames = 1024;
+    const int iterations = 2000;
+
+    std::vector<Sint16> tone;
+    makeTone(tone, 48000, 40);
+    SoftSound sound = {SOFT_SAMPLE_S16, &tone[0], 48000};
+    std::vector<Sint16> out(frames * 2);
+
+    std::vector<float> floatTone(tone.size());
+    for (size_t i = 0; i < tone.size(); i++)
+    {
+        floatTone[i] = tone[i] / 32768.0f;
+    }
+    SoftSound floatSound = {SOFT_SAMPLE_F32, &floatTone[0], 48000};
+    std::vector<Sint16> reference;
+    std::vector<Sint16> check;
+    renderSoftMixerCheck(MIX_KERNEL_SCALAR, &sound, &floatSound, reference);
+
+    printf("soft_mixer %d voices, %d frame buffers\n", voices, frames);
+    for (int p = 0; p < MIX_KERNEL_TOTAL; p++)
+    {
+        MixKernels kernels;
+        if (!getMixKernels((MixKernelPath) p, &kernels) || (p == MIX_KERNEL_AVX2 && !SDL_HasAVX2()) || (p == MIX_KERNEL_SSE2 && !SDL_HasSSE2()))
+        {
+            printf("  %-8s unavailable\n", getMixKernelPathName((MixKernelPath) p));
+            continue;
+        }
+
+        // Every path has to produce the scalar path's samples
+        renderSoftMixerCheck((MixKernelPath) p, &sound, &floatSound, check);
+        size_t mismatch = 0;
+        while (mismatch < check.size() && check[mismatch] == reference[mismatch])
+        {
+            mismatch++;
+        }
+        if (check.size() != reference.size() || mismatch < check.size())
+        {
+            printf("  %-8s MISMATCH with scalar at sample %u\n", getMixKernelPathName((MixKernelPath) p), (unsigned) mismatch);
+            SDL_assert_release(!"soft mixer kernel output differs from scalar");
+            continue;
+        }
+
+        SoftMixer mixer;
+        mixer.init(48000, voices, (MixKernelPath) p);
+        for (int v = 0; v < voices; v++)
+        {
+            mixer.play(&sound, 0.1f, (v % 9) / 4.0f - 1.0f, true);
+        }
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int i = 0; i < iterations; i++)
+        {
+            memset(&out[0], 0, out.size() * sizeof(Sint16));
+            mixer.mix(&out[0], frames);
+        }
+        double ms = secondsSince(start) * 1000.0;
+        printf("  %-8s %10.1f voices/ms\n", getMixKernelPathName((MixKernelPath) p), (double) voices * iterations / ms);
+    }
+
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0)
+    {
+        printf("  callback: %s\n", SDL_GetError());
+        return;
+    }
+
+    const char* names[] = {"Mix_PlayChannel", "soft mixer"};
+    for (int mode = 0; mode < 2; mode++)
+    {
+        if (!openAudio(AUDIO_LATENCY_SAFE))
+        {
+            break;
+        }
+        Uint16 format;
+        int channels;
+        int frequency;
+        Mix_QuerySpec(&frequency, &format, &channels);
+        makeTone(tone, frequency, 40);
+        sound.samples = &tone[0];
+        sound.frames = frequency;
+
+        Mix_Chunk* chunk = Mix_QuickLoad_RAW((Uint8*) &tone[0], (Uint32) (tone.size() * sizeof(Sint16)));
+        SoftMixer mixer;
+        if (mode == 0)
+        {
+            Mix_AllocateChannels(voices);
+            for (int v = 0; v < voices; v++)
+            {
+                Mix_PlayChannel(v, chunk, -1);
+            }
+        } else {
+            mixer.init(frequency, voices, selectMixKernelPath());
+            for (int v = 0; v < voices; v++)
+            {
+                mixer.play(&sound, 0.1f, 0.0f, true);
+            }
+            setAudioPostMix(SoftMixer::postMix, &mixer);
+        }
+
+        SDL_Delay(1000);
+        double callbackMs = getMixerCallbackMs();
+        printf("  %-16s %6.3f ms per %d frame callback, %10.1f voices/ms\n", names[mode], callbackMs, getAudioChunkSize(),
+            callbackMs > 0.0 ? voices * (getAudioChunkSize() / 1024.0) / callbackMs : 0.0);
+
+        setAudioPostMix(NULL, NULL);
+        Mix_HaltChannel(-1);
+        Mix_FreeChunk(chunk);
+        closeAudio();
+    }
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+}
+
+// 16-bit PCM wav, the format the packer and Mix_LoadWAV both take.
+static bool writeWav(const char* path, const std::vector<Sint16>& samples, int frequency, int channels)
+{
+    SDL_RWops* rw = SDL_RWFromFile(path, "wb");
+    if (rw == NULL)
+    {
+        return false;
+    }
+    Uint32 dataBytes = (Uint32) (samples.size() * sizeof(Sint16));
+    SDL_WriteLE32(rw, 0x46464952); // RIFF
+    SDL_WriteLE32(rw, 36 + dataBytes);
+    SDL_WriteLE32(rw, 0x45564157); // WAVE
+    SDL_WriteLE32(rw, 0x20746D66); // fmt
+    SDL_WriteLE32(rw, 16);
+    SDL_WriteLE16(rw, 1);
+    SDL_WriteLE16(rw, (Uint16) channels);
+    SDL_WriteLE32(rw, (Uint32) frequency);
+    SDL_WriteLE32(rw, (Uint32) (frequency * channels * 2));
+    SDL_WriteLE16(rw, (Uint16) (channels * 2));
+    SDL_WriteLE16(rw, 16);
+    SDL_WriteLE32(rw, 0x61746164); // data
+    SDL_WriteLE32(rw, dataBytes);
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        SDL_WriteLE16(rw, (Uint16) samples[i]);
+    }
+    SDL_RWclose(rw);
+    return true;
+}
+
+// Startup cost of the effects: every wav through Mix_LoadWAV, which decodes
+// and resamples, against mapping one pre-converted bank. The wavs are 22050
+// Hz mono so the loose path has real conversion work to do.
+static void benchSoundBank()
+{
+    const int sounds = 16;
+    const int iterations = 20;
+
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0)
+    {
+        printf("sound_bank: %s\n", SDL_GetError());
+        return;
+    }
+    if (!openAudio(AUDIO_LATENCY_BALANCED))
+    {
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return;
+    }
+    int frequency;
+    Uint16 format;
+    int channels;
+    Mix_QuerySpec(&frequency, &format, &channels);
+
+    std::vector<std::string> names;
+    std::vector<std::string> files;
+    for (int i = 0; i < sounds; i++)
+    {
+        char name[32];
+        SDL_snprintf(name, sizeof(name), "bench_sound%d", i);
+        std::vector<Sint16> tone(22050 / 2);
+        for (size_t f = 0; f < tone.size(); f++)
+        {
+            tone[f] = (Sint16) ((f / (10 + i)) % 2 ? 3000 : -3000);
+        }
+        names.push_back(name);
+        files.push_back(std::string(name) + ".wav");
+        writeWav(files.back().c_str(), tone, 22050, 1);
+    }
+    const char* bankPath = "bench_sounds.bank";
+    if (!writeSoundBank(bankPath, names, files, frequency, format, channels))
+    {
+        printf("sound_bank: packing failed\n");
+    } else {
+        printf("sound_bank %d half second sounds at %d Hz, %d channels, %d runs\n", sounds, frequency, channels, iterations);
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int n = 0; n < iterations; n++)
+        {
+            std::vector<Mix_Chunk*> chunks;
+            for (int i = 0; i < sounds; i++)
+            {
+                chunks.push_back(Mix_LoadWAV(files[i].c_str()));
+            }
+            for (int i = 0; i < sounds; i++)
+            {
+                Mix_FreeChunk(chunks[i]);
+            }
+        }
+        double wavMs = secondsSince(start) * 1000.0 / iterations;
+
+        start = SDL_GetPerformanceCounter();
+        int found = 0;
+        for (int n = 0; n < iterations; n++)
+        {
+            SoundBank bank;
+            bank.open(bankPath);
+            for (int i = 0; i < sounds; i++)
+            {
+                found += bank.getChunk(names[i].c_str()) != NULL;
+            }
+        }
+        double bankMs = secondsSince(start) * 1000.0 / iterations;
+
+        printf("  %-12s %8.3f ms\n", "Mix_LoadWAV", wavMs);
+        printf("  %-12s %8.3f ms (%d/%d found)\n", "sound bank", bankMs, found, sounds * iterations);
+    }
+
+    for (int i = 0; i < sounds; i++)
+    {
+        remove(files[i].c_str());
+    }
+    remove(bankPath);
+    closeAudio();
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+}
+
+// Streams a long generated track through the mixer's music hook on the
+// dummy driver at a few read-ahead settings. Memory stays at the ring size
+// however long the track is; underruns show how much read-ahead it takes.
+static void benchMusicStream()
+{
+    const int trackSeconds = 120;
+    const int playMs = 2000;
+    const int readAheads[] = {10, 50, 200, 1000};
+    const char* path = "bench_music.wav";
+
+    std::vector<Sint16> track(22050 * trackSeconds);
+    for (size_t i = 0; i < track.size(); i++)
+    {
+        track[i] = (Sint16) ((i / 50) % 2 ? 2000 : -2000);
+    }
+    if (!writeWav(path, track, 22050, 1))
+    {
+        printf("music_stream: can't write %s\n", path);
+        return;
+    }
+    size_t trackBytes = track.size() * sizeof(Sint16);
+    std::vector<Sint16>().swap(track);
+
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0 || !openAudio(AUDIO_LATENCY_LOW))
+    {
+        printf("music_stream: %s\n", SDL_GetError());
+        remove(path);
+        return;
+    }
+
+    printf("music_stream %d s track (%d KB as wav), %d ms played per setting, %d frame device buffer\n", trackSeconds,
+        (int) (trackBytes / 1024), playMs, getAudioChunkSize());
+    for (size_t r = 0; r < sizeof(readAheads) / sizeof(readAheads[0]); r++)
+    {
+        MusicStream music;
+        music.setReadAheadMs(readAheads[r]);
+        if (!music.open(path))
+        {
+            break;
+        }
+        setAudioMusicSource(MusicStream::mixSource, &music);
+        music.play(false);
+        SDL_Delay(playMs);
+        setAudioMusicSource(NULL, NULL);
+
+        printf("  %5d ms read-ahead %6d KB resident %4d underruns, lowest fill %7.1f ms\n", readAheads[r],
+            (int) (music.getMemoryBytes() / 1024), music.getUnderrunCount(), music.getMinBufferedMs());
+        music.close();
+    }
+
+    closeAudio();
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    remove(path);
+}
+
+// Cost of one PROFILE_SCOPE against an empty loop. Only meaningful in a
+// build with -DPROFILER_ENABLED=1, the optimized bench compiles it out.
+static void benchProfiler()
+{
+    const int scopes = 1000000;
+
+    volatile int sink = 0;
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < scopes; i++)
+    {
+        sink = sink + i;
+    }
+    double empty = secondsSince(start);
+
+    start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < scopes; i++)
+    {
+        PROFILE_SCOPE("bench");
+        sink = sink + i;
+    }
+    double scoped = secondsSince(start);
+
+    printf("profiler %d scopes, %s\n", scopes, PROFILER_ENABLED ? "enabled" : "compiled out");
+    printf("  %8.1f ns per scope\n", (scoped - empty) * 1e9 / scopes);
+}
+
+struct BenchDrawCommand
+{
+    SDL_Texture* texture;
+    SDL_Rect src;
+    SDL_Rect dst;
+    SDL_Color color;
+    const char* label;
+};
+
+static Uint32 sumDrawCommands(const BenchDrawCommand* commands, size_t count)
+{
+    Uint32 sum = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        sum += (Uint32) commands[i].dst.x + (commands[i].label != NULL ? (Uint8) commands[i].label[0] : 0);
+    }
+    return sum;
+}
+
+// A frame of 10k draw commands, one in eight with a formatted label, built
+// in a fresh, reserved vector the way transient per-frame lists are: once
+// from the heap with std::string labels, once from a FrameArena.
+static void benchFrameArena()
+{
+    const int commands = 10000;
+    const int frames = 200;
+    const int labelEvery = 8;
+
+    BenchDrawCommand command;
+    command.texture = NULL;
+    SDL_Rect rect = {0, 0, 32, 32};
+    command.src = rect;
+    command.dst = rect;
+    SDL_Color white = {0xFF, 0xFF, 0xFF, 0xFF};
+    command.color = white;
+    char text[32];
+
+    volatile Uint32 sink = 0;
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int f = 0; f < frames; f++)
+    {
+        std::vector<BenchDrawCommand> list;
+        list.reserve(commands);
+        std::vector<std::string> labels;
+        labels.reserve(commands / labelEvery);
+        for (int i = 0; i < commands; i++)
+        {
+            command.dst.x = (i * 37) % 1024;
+            command.label = NULL;
+            if (i % labelEvery == 0)
+            {
+                SDL_snprintf(text, sizeof(text), "button %d", i + f);
+                labels.push_back(text);
+                command.label = labels.back().c_str();
+            }
+            list.push_back(command);
+        }
+        sink = sink + sumDrawCommands(list.data(), list.size());
+    }
+    double heap = secondsSince(start);
+
+    FrameArena arena;
+    arena.init(1024 * 1024);
+    start = SDL_GetPerformanceCounter();
+    for (int f = 0; f < frames; f++)
+    {
+        std::vector<BenchDrawCommand, FrameAllocator<BenchDrawCommand> > list((FrameAllocator<BenchDrawCommand>(&arena)));
+        list.reserve(commands);
+        for (int i = 0; i < commands; i++)
+        {
+            command.dst.x = (i * 37) % 1024;
+            command.label = NULL;
+            if (i % labelEvery == 0)
+            {
+                command.label = arena.format("button %d", i + f);
+            }
+            list.push_back(command);
+        }
+        sink = sink + sumDrawCommands(list.data(), list.size());
+        arena.endFrame();
+    }
+    double arenaSeconds = secondsSince(start);
+    // Otherwise the arena timing includes heap allocations
+    SDL_assert_release(arena.getOverflowCount() == 0);
+
+    printf("frame_arena %d draw commands/frame, %d labels\n", commands, commands / labelEvery);
+    printf("  heap   %8.3f ms/frame\n", heap * 1000.0 / frames);
+    printf("  arena  %8.3f ms/frame, peak %u KB, %d overflows\n", arenaSeconds * 1000.0 / frames,
+        (unsigned) (arena.getPeakUsed() / 1024), arena.getOverflowCount());
+}
+
+struct BenchScenario
+{
+    const char* name;
+    void (*run)();
+};
+
+static BenchScenario gScenarios[] = {
+    {"color_key_scan", benchColorKeyScan},
+    {"sprite_batch", benchSpriteBatch},
+    {"texture_render", benchTextureRender},
+    {"text_render", benchTextRender},
+    {"dirty_rects", benchDirtyRects},
+    {"hit_test", benchHitTest},
+    {"audio_latency", benchAudioLatency},
+    {"soft_mixer", benchSoftMixer},
+    {"sound_bank", benchSoundBank},
+    {"music_stream", benchMusicStream},
+    {"profiler", benchProfiler},
+    {"frame_arena", benchFrameArena},
+};
+
+int main(int argc, char* args[])
+{
+    if (SDL_Init(0) < 0)
+    {
+        printf("error initializing: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    int count = (int) (sizeof(gScenarios) / sizeof(gScenarios[0]));
+    for (int i = 0; i < count; i++)
+    {
+        bool selected = argc < 2;
+        for (int a = 1; a < argc; a++)
+        {
+            if (strcmp(args[a], gScenarios[i].name) == 0)
+            {
+                selected = true;
+            }
+        }
+        if (selected)
+        {
+            gScenarios[i].run();
+        }
+    }
+
+    SDL_Quit();
+    return 0;
+}
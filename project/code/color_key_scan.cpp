@@ -0,0 +1,175 @@
+#include "color_key_scan.h"
+
+#include "SDL_cpuinfo.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define COLOR_KEY_SCAN_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define COLOR_KEY_TARGET_SSE2 __attribute__((target("sse2")))
+#define COLOR_KEY_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define COLOR_KEY_TARGET_SSE2
+#define COLOR_KEY_TARGET_AVX2
+#endif
+
+static void colorKeyScanScalar(const Uint32* pixels, int count, Uint32 key, Uint32 compareMask, Uint8* bits)
+{
+    key &= compareMask;
+    int x = 0;
+    for (; x + 8 <= count; x += 8)
+    {
+        Uint8 byte = 0;
+        for (int i = 0; i < 8; i++)
+        {
+            byte |= (Uint8) (((pixels[x + i] & compareMask) != key) << i);
+        }
+        bits[x >> 3] = byte;
+    }
+    if (x < count)
+    {
+        Uint8 byte = 0;
+        for (int i = 0; x + i < count; i++)
+        {
+            byte |= (Uint8) (((pixels[x + i] & compareMask) != key) << i);
+        }
+        bits[x >> 3] = byte;
+    }
+}
+
+#ifdef COLOR_KEY_SCAN_X86
+// 16 pixels per iteration, four 4-wide compares folded into two mask bytes.
+COLOR_KEY_TARGET_SSE2
+static void colorKeyScanSSE2(const Uint32* pixels, int count, Uint32 key, Uint32 compareMask, Uint8* bits)
+{
+    const __m128i vMask = _mm_set1_epi32((int) compareMask);
+    const __m128i vKey = _mm_set1_epi32((int) (key & compareMask));
+
+    int x = 0;
+    for (; x + 16 <= count; x += 16)
+    {
+        const __m128i* p = (const __m128i*) (pixels + x);
+        __m128i c0 = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(p + 0), vMask), vKey);
+        __m128i c1 = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(p + 1), vMask), vKey);
+        __m128i c2 = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(p + 2), vMask), vKey);
+        __m128i c3 = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(p + 3), vMask), vKey);
+
+        int m = _mm_movemask_ps(_mm_castsi128_ps(c0))
+            | (_mm_movemask_ps(_mm_castsi128_ps(c1)) << 4)
+            | (_mm_movemask_ps(_mm_castsi128_ps(c2)) << 8)
+            | (_mm_movemask_ps(_mm_castsi128_ps(c3)) << 12);
+        m = ~m;
+
+        bits[(x >> 3) + 0] = (Uint8) m;
+        bits[(x >> 3) + 1] = (Uint8) (m >> 8);
+    }
+    if (x < count)
+    {
+        colorKeyScanScalar(pixels + x, count - x, key, compareMask, bits + (x >> 3));
+    }
+}
+
+// 32 pixels per iteration, four 8-wide compares folded into four mask bytes.
+COLOR_KEY_TARGET_AVX2
+static void colorKeyScanAVX2(const Uint32* pixels, int count, Uint32 key, Uint32 compareMask, Uint8* bits)
+{
+    const __m256i vMask = _mm256_set1_epi32((int) compareMask);
+    const __m256i vKey = _mm256_set1_epi32((int) (key & compareMask));
+
+    int x = 0;
+    for (; x + 32 <= count; x += 32)
+    {
+        const __m256i* p = (const __m256i*) (pixels + x);
+        __m256i c0 = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_loadu_si256(p + 0), vMask), vKey);
+        __m256i c1 = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_loadu_si256(p + 1), vMask), vKey);
+        __m256i c2 = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_loadu_si256(p + 2), vMask), vKey);
+        __m256i c3 = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_loadu_si256(p + 3), vMask), vKey);
+
+        Uint32 m = (Uint32) _mm256_movemask_ps(_mm256_castsi256_ps(c0))
+            | ((Uint32) _mm256_movemask_ps(_mm256_castsi256_ps(c1)) << 8)
+            | ((Uint32) _mm256_movemask_ps(_mm256_castsi256_ps(c2)) << 16)
+            | ((Uint32) _mm256_movemask_ps(_mm256_castsi256_ps(c3)) << 24);
+        m = ~m;
+
+        bits[(x >> 3) + 0] = (Uint8) m;
+        bits[(x >> 3) + 1] = (Uint8) (m >> 8);
+        bits[(x >> 3) + 2] = (Uint8) (m >> 16);
+        bits[(x >> 3) + 3] = (Uint8) (m >> 24);
+    }
+    if (x < count)
+    {
+        colorKeyScanSSE2(pixels + x, count - x, key, compareMask, bits + (x >> 3));
+    }
+}
+#endif
+
+ColorKeyScanFunc getColorKeyScanFunc(ColorKeyScanPath path)
+{
+    switch (path)
+    {
+    case COLOR_KEY_SCAN_SCALAR:
+    return colorKeyScanScalar;
+
+#ifdef COLOR_KEY_SCAN_X86
+    case COLOR_KEY_SCAN_SSE2:
+    return colorKeyScanSSE2;
+
+    case COLOR_KEY_SCAN_AVX2:
+    return colorKeyScanAVX2;
+#endif
+
+    default:
+    return NULL;
+    }
+}
+
+ColorKeyScanPath selectColorKeyScanPath()
+{
+#ifdef COLOR_KEY_SCAN_X86
+    if (SDL_HasAVX2())
+    {
+        return COLOR_KEY_SCAN_AVX2;
+    }
+    if (SDL_HasSSE2())
+    {
+        return COLOR_KEY_SCAN_SSE2;
+    }
+#endif
+    return COLOR_KEY_SCAN_SCALAR;
+}
+
+const char* getColorKeyScanPathName(ColorKeyScanPath path)
+{
+    switch (path)
+    {
+    case COLOR_KEY_SCAN_SCALAR:
+    return "scalar";
+
+    case COLOR_KEY_SCAN_SSE2:
+    return "sse2";
+
+    case COLOR_KEY_SCAN_AVX2:
+    return "avx2";
+
+    default:
+    return "unknown";
+    }
+}
+
+static void colorKeyScanResolve(const Uint32* pixels, int count, Uint32 key, Uint32 compareMask, Uint8* bits);
+
+static ColorKeyScanFunc gColorKeyScan = colorKeyScanResolve;
+
+static void colorKeyScanResolve(const Uint32* pixels, int count, Uint32 key, Uint32 compareMask, Uint8* bits)
+{
+    gColorKeyScan = getColorKeyScanFunc(selectColorKeyScanPath());
+    gColorKeyScan(pixels, count, key, compareMask, bits);
+}
+
+void colorKeyScan(const Uint32* pixels, int count, Uint32 key, Uint32 compareMask, Uint8* bits)
+{
+    gColorKeyScan(pixels, count, key, compareMask, bits);
+}
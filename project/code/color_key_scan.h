@@ -0,0 +1,31 @@
+#ifndef COLOR_KEY_SCAN_H
+#define COLOR_KEY_SCAN_H
+
+#include "SDL_stdinc.h"
+
+enum ColorKeyScanPath
+{
+    COLOR_KEY_SCAN_SCALAR = 0,
+    COLOR_KEY_SCAN_SSE2 = 1,
+    COLOR_KEY_SCAN_AVX2 = 2,
+    COLOR_KEY_SCAN_TOTAL = 3
+};
+
+// Compares count contiguous pixels against key and writes one bit per pixel
+// to bits, least significant bit first. A set bit means the pixel is opaque,
+// i.e. (pixel & compareMask) != (key & compareMask). bits must hold
+// (count + 7) / 8 bytes.
+typedef void (*ColorKeyScanFunc)(const Uint32* pixels, int count, Uint32 key, Uint32 compareMask, Uint8* bits);
+
+// Returns NULL if the path was not compiled in for this target.
+ColorKeyScanFunc getColorKeyScanFunc(ColorKeyScanPath path);
+
+// Widest path the running CPU supports, via SDL_HasAVX2/SDL_HasSSE2.
+ColorKeyScanPath selectColorKeyScanPath();
+
+const char* getColorKeyScanPathName(ColorKeyScanPath path);
+
+// Scans with the path picked by selectColorKeyScanPath() on first use.
+void colorKeyScan(const Uint32* pixels, int count, Uint32 key, Uint32 compareMask, Uint8* bits);
+
+#endif
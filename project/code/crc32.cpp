@@ -0,0 +1,47 @@
+#include "crc32.h"
+
+static Uint32 gCrc32Table[256];
+static bool gCrc32TableReady = false;
+
+static void crc32BuildTable()
+{
+    for (Uint32 i = 0; i < 256; i++)
+    {
+        Uint32 c = i;
+        for (int k = 0; k < 8; k++)
+        {
+            c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+        }
+        gCrc32Table[i] = c;
+    }
+    gCrc32TableReady = true;
+}
+
+Uint32 crc32Begin()
+{
+    if (!gCrc32TableReady)
+    {
+        crc32BuildTable();
+    }
+    return 0xFFFFFFFF;
+}
+
+Uint32 crc32Update(Uint32 crc, const void* data, size_t size)
+{
+    const Uint8* p = (const Uint8*) data;
+    for (size_t i = 0; i < size; i++)
+    {
+        crc = gCrc32Table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+Uint32 crc32End(Uint32 crc)
+{
+    return crc ^ 0xFFFFFFFF;
+}
+
+Uint32 crc32(const void* data, size_t size)
+{
+    return crc32End(crc32Update(crc32Begin(), data, size));
+}
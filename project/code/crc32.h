@@ -0,0 +1,16 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include "SDL_stdinc.h"
+
+#include <stddef.h>
+
+// Standard reflected CRC-32 (polynomial 0xEDB88320), same as SDLTest_Crc32.
+// Start with crc32Begin(), feed any number of buffers, finish with crc32End().
+Uint32 crc32Begin();
+Uint32 crc32Update(Uint32 crc, const void* data, size_t size);
+Uint32 crc32End(Uint32 crc);
+
+Uint32 crc32(const void* data, size_t size);
+
+#endif
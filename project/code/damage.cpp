@@ -0,0 +1,119 @@
+#include "damage.h"
+#include "profiler.h"
+#include "alloc_tracker.h"
+
+#include <stdio.h>
+
+// Past this many rects the clip and draw overhead per rect outweighs the
+// pixels saved, everything collapses into one bounding rect.
+static const int DAMAGE_MAX_RECTS = 8;
+
+DamageTracker::DamageTracker()
+{
+    mBounds.x = 0;
+    mBounds.y = 0;
+    mBounds.w = 0;
+    mBounds.h = 0;
+    mPartial = false;
+    mRedrawnPixels = 0;
+}
+
+void DamageTracker::init(int width, int height, bool partial)
+{
+    mBounds.w = width;
+    mBounds.h = height;
+    mPartial = partial;
+    addAll();
+}
+
+void DamageTracker::add(const SDL_Rect& rect)
+{
+    if (!mPartial)
+    {
+        addAll();
+        return;
+    }
+
+    SDL_Rect merged;
+    if (!SDL_IntersectRect(&rect, &mBounds, &merged))
+    {
+        return;
+    }
+
+    // Keep folding in whatever the growing rect overlaps
+    size_t i = 0;
+    while (i < mRects.size())
+    {
+        if (SDL_HasIntersection(&merged, &mRects[i]))
+        {
+            SDL_UnionRect(&merged, &mRects[i], &merged);
+            mRects[i] = mRects.back();
+            mRects.pop_back();
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+    mRects.push_back(merged);
+
+    if ((int) mRects.size() > DAMAGE_MAX_RECTS)
+    {
+        SDL_Rect all = mRects[0];
+        for (size_t r = 1; r < mRects.size(); r++)
+        {
+            SDL_UnionRect(&all, &mRects[r], &all);
+        }
+        mRects.assign(1, all);
+    }
+}
+
+void DamageTracker::addAll(){
+    mRects.assign(1, mBounds);
+}
+
+bool DamageTracker::isEmpty() const {
+    return mRects.empty();
+}
+
+const std::vector<SDL_Rect>& DamageTracker::getRects() const {
+    return mRects;
+}
+
+void DamageTracker::clear(){
+    mRects.clear();
+}
+
+void DamageTracker::redraw(SDL_Renderer* renderer, DamageDrawFunc draw, void* userdata)
+{
+    PROFILE_SCOPE("redraw");
+    ALLOC_SCOPE(ALLOC_SUBSYSTEM_RENDER);
+    mRedrawnPixels = 0;
+    for (size_t i = 0; i < mRects.size(); i++)
+    {
+        const SDL_Rect& area = mRects[i];
+        SDL_RenderSetClipRect(renderer, &area);
+        draw(area, userdata);
+        mRedrawnPixels += area.w * area.h;
+    }
+    SDL_RenderSetClipRect(renderer, NULL);
+}
+
+void DamageTracker::present(SDL_Renderer* renderer, SDL_Window* surfaceWindow)
+{
+    PROFILE_SCOPE("present");
+    ALLOC_SCOPE(ALLOC_SUBSYSTEM_RENDER);
+    if (surfaceWindow != NULL)
+    {
+        if (!mRects.empty() && SDL_UpdateWindowSurfaceRects(surfaceWindow, mRects.data(), (int) mRects.size()) < 0)
+        {
+            printf("Unable to update window surface, Error: %s\n", SDL_GetError());
+        }
+    } else {
+        SDL_RenderPresent(renderer);
+    }
+    clear();
+}
+
+int DamageTracker::getRedrawnPixels() const {
+    return mRedrawnPixels;
+}
@@ -0,0 +1,49 @@
+#ifndef DAMAGE_H
+#define DAMAGE_H
+
+#include "SDL.h"
+
+#include <vector>
+
+typedef void (*DamageDrawFunc)(const SDL_Rect& area, void* userdata);
+
+// Collects the parts of the window that changed since the last present and
+// redraws only those, clipped, then pushes only those to the window. This
+// pays off on the software renderer, where the window surface keeps its
+// pixels between frames. Accelerated back buffers don't, so there every
+// damaged frame is redrawn whole.
+class DamageTracker
+{
+    public:
+        DamageTracker();
+
+        // partial: the render target keeps its contents between presents.
+        void init(int width, int height, bool partial);
+
+        void add(const SDL_Rect& rect);
+        void addAll();
+
+        bool isEmpty() const;
+        // Overlapping rects are merged, the list stays short.
+        const std::vector<SDL_Rect>& getRects() const;
+        void clear();
+
+        // Calls draw once per damaged rect with the renderer clipped to it.
+        void redraw(SDL_Renderer* renderer, DamageDrawFunc draw, void* userdata);
+
+        // For a software renderer drawing into surfaceWindow's surface only
+        // the damaged rects are copied to the screen; NULL does a normal
+        // SDL_RenderPresent. Clears the damage.
+        void present(SDL_Renderer* renderer, SDL_Window* surfaceWindow);
+
+        // Pixels covered by the last redraw()
+        int getRedrawnPixels() const;
+
+    private:
+        std::vector<SDL_Rect> mRects;
+        SDL_Rect mBounds;
+        bool mPartial;
+        int mRedrawnPixels;
+};
+
+#endif
@@ -0,0 +1,160 @@
+#include "frame_arena.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+// Most formatted strings fit the first try
+static const size_t FRAME_ARENA_FORMAT_BYTES = 256;
+static const size_t FRAME_ARENA_MAX_FORMAT_BYTES = 64 * 1024;
+
+FrameArena::FrameArena()
+{
+    for (int i = 0; i < 2; i++)
+    {
+        mBuffers[i].base = NULL;
+        mBuffers[i].used = 0;
+        mBuffers[i].overflow = NULL;
+    }
+    mCurrent = 0;
+    mCapacity = 0;
+    mPeakUsed = 0;
+    mOverflows = 0;
+}
+
+FrameArena::~FrameArena()
+{
+    free();
+}
+
+bool FrameArena::init(size_t bytesPerFrame)
+{
+    free();
+    for (int i = 0; i < 2; i++)
+    {
+        mBuffers[i].base = (Uint8*) SDL_malloc(bytesPerFrame);
+        if (mBuffers[i].base == NULL)
+        {
+            printf("Unable to allocate a %u byte frame arena\n", (unsigned) bytesPerFrame);
+            free();
+            return false;
+        }
+    }
+    mCapacity = bytesPerFrame;
+    return true;
+}
+
+void FrameArena::free()
+{
+    for (int i = 0; i < 2; i++)
+    {
+        release(mBuffers[i]);
+        SDL_free(mBuffers[i].base);
+        mBuffers[i].base = NULL;
+    }
+    mCurrent = 0;
+    mCapacity = 0;
+    mPeakUsed = 0;
+    mOverflows = 0;
+}
+
+void FrameArena::release(Buffer& buffer)
+{
+    Overflow* block = buffer.overflow;
+    while (block != NULL)
+    {
+        Overflow* next = block->next;
+        SDL_free(block);
+        block = next;
+    }
+    buffer.overflow = NULL;
+    buffer.used = 0;
+}
+
+void* FrameArena::alloc(size_t size)
+{
+    Buffer& buffer = mBuffers[mCurrent];
+    if (buffer.base != NULL)
+    {
+        size_t start = (size_t) (((size_t) buffer.base + buffer.used + FRAME_ARENA_ALIGN - 1) & ~(FRAME_ARENA_ALIGN - 1)) - (size_t) buffer.base;
+        if (start + size <= mCapacity)
+        {
+            buffer.used = start + size;
+            if (buffer.used > mPeakUsed)
+            {
+                mPeakUsed = buffer.used;
+            }
+            return buffer.base + start;
+        }
+    }
+
+    // The header is padded so the block keeps malloc's alignment
+    Overflow* block = (Overflow*) SDL_malloc(FRAME_ARENA_ALIGN + size);
+    if (block == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    block->next = buffer.overflow;
+    buffer.overflow = block;
+    mOverflows++;
+    return (Uint8*) block + FRAME_ARENA_ALIGN;
+}
+
+char* FrameArena::format(const char* fmt, ...)
+{
+    // SDL's own vsnprintf, used where the C library has none, returns what
+    // it wrote rather than the full length. So a result that fills the
+    // buffer counts as cut off and is retried in a bigger one.
+    char buffer[FRAME_ARENA_FORMAT_BYTES];
+    va_list args;
+    va_start(args, fmt);
+    int length = SDL_vsnprintf(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+    if (length >= 0 && length < (int) sizeof(buffer) - 1)
+    {
+        char* text = (char*) alloc(length + 1);
+        memcpy(text, buffer, length + 1);
+        return text;
+    }
+
+    size_t size = sizeof(buffer) * 2;
+    for (;;)
+    {
+        char* text = (char*) alloc(size);
+        va_start(args, fmt);
+        length = SDL_vsnprintf(text, size, fmt, args);
+        va_end(args);
+        if ((length >= 0 && length < (int) size - 1) || size >= FRAME_ARENA_MAX_FORMAT_BYTES)
+        {
+            return text;
+        }
+        size *= 2;
+    }
+}
+
+void FrameArena::endFrame(){
+    mCurrent ^= 1;
+    release(mBuffers[mCurrent]);
+}
+
+size_t FrameArena::getCapacity() const {
+    return mCapacity;
+}
+
+size_t FrameArena::getUsed() const {
+    return mBuffers[mCurrent].used;
+}
+
+size_t FrameArena::getPeakUsed() const {
+    return mPeakUsed;
+}
+
+int FrameArena::getOverflowCount() const {
+    return mOverflows;
+}
+
+void FrameArena::printStats() const
+{
+    printf("frame arena: 2 x %u KB, peak %u KB, %d overflow allocations\n", (unsigned) (mCapacity / 1024),
+        (unsigned) (mPeakUsed / 1024), mOverflows);
+}
@@ -0,0 +1,146 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include "SDL.h"
+
+#include <new>
+#include <stddef.h>
+
+const size_t FRAME_ARENA_ALIGN = 16;
+
+// Bump allocator for data that only lives for a frame: command lists,
+// formatted strings, scratch arrays. Two buffers are used in turn and
+// endFrame() only resets the one being switched to, so whatever the frame
+// just presented allocated stays valid until the end of the next frame.
+// Nothing is freed one by one. When a frame outgrows its buffer the rest
+// comes from the heap and is released with the buffer; getOverflowCount()
+// says the arena should be bigger. Main thread only.
+class FrameArena
+{
+    public:
+        FrameArena();
+        ~FrameArena();
+
+        // bytesPerFrame is the size of each of the two buffers.
+        bool init(size_t bytesPerFrame);
+        void free();
+
+        void* alloc(size_t size);
+        template <typename T> T* allocArray(size_t count);
+        // printf into arena memory, cut off past 64 KB
+        char* format(const char* fmt, ...);
+
+        // Call right after presenting.
+        void endFrame();
+
+        size_t getCapacity() const;
+        // Bytes handed out this frame
+        size_t getUsed() const;
+        size_t getPeakUsed() const;
+        // Heap allocations because a frame did not fit, since init
+        int getOverflowCount() const;
+
+        void printStats() const;
+
+    private:
+        FrameArena(const FrameArena&);
+        FrameArena& operator=(const FrameArena&);
+
+        struct Overflow
+        {
+            Overflow* next;
+        };
+
+        struct Buffer
+        {
+            Uint8* base;
+            size_t used;
+            Overflow* overflow;
+        };
+
+        void release(Buffer& buffer);
+
+        Buffer mBuffers[2];
+        int mCurrent;
+        size_t mCapacity;
+        size_t mPeakUsed;
+        int mOverflows;
+};
+
+template <typename T>
+T* FrameArena::allocArray(size_t count){
+    return (T*) alloc(count * sizeof(T));
+}
+
+// Lets standard containers draw from a FrameArena:
+//
+//   std::vector<SDL_Rect, FrameAllocator<SDL_Rect> > rects((FrameAllocator<SDL_Rect>(&gFrameArena)));
+//
+// deallocate() does nothing, the memory comes back when the arena resets,
+// so the container must not outlive the frame after the one it was filled
+// in. Growing a vector leaves the old storage behind, reserve() up front
+// when the size is known.
+template <typename T>
+class FrameAllocator
+{
+    public:
+        typedef T value_type;
+        typedef T* pointer;
+        typedef const T* const_pointer;
+        typedef T& reference;
+        typedef const T& const_reference;
+        typedef size_t size_type;
+        typedef ptrdiff_t difference_type;
+
+        template <typename U>
+        struct rebind
+        {
+            typedef FrameAllocator<U> other;
+        };
+
+        explicit FrameAllocator(FrameArena* arena) : mArena(arena) {}
+        template <typename U>
+        FrameAllocator(const FrameAllocator<U>& other) : mArena(other.getArena()) {}
+
+        T* allocate(size_t count, const void* hint = 0){
+            return mArena->allocArray<T>(count);
+        }
+        void deallocate(T* p, size_t count){
+        }
+
+        void construct(T* p, const T& value){
+            new (p) T(value);
+        }
+        void destroy(T* p){
+            p->~T();
+        }
+
+        T* address(T& value) const {
+            return &value;
+        }
+        const T* address(const T& value) const {
+            return &value;
+        }
+        size_t max_size() const {
+            return ((size_t) -1) / sizeof(T);
+        }
+
+        FrameArena* getArena() const {
+            return mArena;
+        }
+
+    private:
+        FrameArena* mArena;
+};
+
+template <typename T, typename U>
+bool operator==(const FrameAllocator<T>& a, const FrameAllocator<U>& b){
+    return a.getArena() == b.getArena();
+}
+
+template <typename T, typename U>
+bool operator!=(const FrameAllocator<T>& a, const FrameAllocator<U>& b){
+    return a.getArena() != b.getArena();
+}
+
+#endif
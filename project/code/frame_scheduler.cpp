@@ -0,0 +1,136 @@
+#include "frame_scheduler.h"
+#include "profiler.h"
+
+#include <stdio.h>
+
+FrameScheduler::FrameScheduler()
+{
+    mWakeEvent = (Uint32) -1;
+    mFrameInterval = 0;
+    mLastFrame = 0;
+    mWakeAt = 0;
+    mHasWakeAt = false;
+    // The first frame always needs drawing
+    mDirty = true;
+    mFramesRendered = 0;
+    mWakeups = 0;
+    mIdleMs = 0;
+}
+
+bool FrameScheduler::init()
+{
+    mWakeEvent = SDL_RegisterEvents(1);
+    if (mWakeEvent == (Uint32) -1)
+    {
+        printf("Unable to register wake event, Error: %s\n", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+void FrameScheduler::setMaxFps(int fps){
+    mFrameInterval = fps > 0 ? (Uint32) (1000 / fps) : 0;
+}
+
+int FrameScheduler::getMaxFps() const {
+    return mFrameInterval > 0 ? (int) (1000 / mFrameInterval) : 0;
+}
+
+void FrameScheduler::markDirty(){
+    mDirty = true;
+}
+
+bool FrameScheduler::isDirty() const {
+    return mDirty;
+}
+
+void FrameScheduler::scheduleAt(Uint32 ticks)
+{
+    if (!mHasWakeAt || SDL_TICKS_PASSED(mWakeAt, ticks))
+    {
+        mWakeAt = ticks;
+        mHasWakeAt = true;
+    }
+}
+
+void FrameScheduler::wake()
+{
+    if (mWakeEvent == (Uint32) -1)
+    {
+        return;
+    }
+    SDL_Event e;
+    SDL_zero(e);
+    e.type = mWakeEvent;
+    SDL_PushEvent(&e);
+}
+
+Uint32 FrameScheduler::getWakeEventType() const {
+    return mWakeEvent;
+}
+
+void FrameScheduler::waitForWork()
+{
+    PROFILE_SCOPE("wait");
+    Uint32 now = SDL_GetTicks();
+
+    // A dirty frame only waits for its slot, a clean one for the next
+    // scheduled wake-up or forever
+    int timeout = -1;
+    if (mDirty)
+    {
+        Uint32 slot = mLastFrame + mFrameInterval;
+        timeout = SDL_TICKS_PASSED(now, slot) ? 0 : (int) (slot - now);
+    } else if (mHasWakeAt) {
+        timeout = SDL_TICKS_PASSED(now, mWakeAt) ? 0 : (int) (mWakeAt - now);
+    }
+
+    if (timeout == 0)
+    {
+        return;
+    }
+
+    if (timeout < 0)
+    {
+        SDL_WaitEvent(NULL);
+    } else {
+        SDL_WaitEventTimeout(NULL, timeout);
+    }
+    mWakeups++;
+    mIdleMs += SDL_GetTicks() - now;
+}
+
+bool FrameScheduler::shouldRender()
+{
+    Uint32 now = SDL_GetTicks();
+    if (mHasWakeAt && SDL_TICKS_PASSED(now, mWakeAt))
+    {
+        mHasWakeAt = false;
+        mDirty = true;
+    }
+    return mDirty && SDL_TICKS_PASSED(now, mLastFrame + mFrameInterval);
+}
+
+void FrameScheduler::frameRendered()
+{
+    mDirty = false;
+    mLastFrame = SDL_GetTicks();
+    mFramesRendered++;
+}
+
+int FrameScheduler::getFramesRendered() const {
+    return mFramesRendered;
+}
+
+int FrameScheduler::getWakeups() const {
+    return mWakeups;
+}
+
+Uint32 FrameScheduler::getIdleMs() const {
+    return mIdleMs;
+}
+
+void FrameScheduler::printStats() const
+{
+    printf("frames: %d rendered, %d wakeups, %u ms idle of %u ms\n", mFramesRendered, mWakeups, mIdleMs, SDL_GetTicks());
+}
@@ -0,0 +1,59 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include "SDL.h"
+
+// Decides when the main loop renders. Anything that changes what is on
+// screen calls markDirty(); between frames the loop sleeps in
+// SDL_WaitEventTimeout until an event arrives, a requested wake-up time is
+// reached or, when capped, the next frame slot opens.
+class FrameScheduler
+{
+    public:
+        FrameScheduler();
+
+        // Registers the user event used by wake(). Call after SDL_Init.
+        bool init();
+
+        // 0 renders as soon as something is dirty, for vsynced renderers.
+        void setMaxFps(int fps);
+        int getMaxFps() const;
+
+        void markDirty();
+        bool isDirty() const;
+
+        // Makes the frame at ticks dirty, e.g. the next animation step.
+        void scheduleAt(Uint32 ticks);
+
+        // Thread-safe, interrupts waitForWork() from any thread.
+        void wake();
+        Uint32 getWakeEventType() const;
+
+        // Blocks until there is something to do. Events stay in the queue.
+        void waitForWork();
+
+        // True when a dirty frame may be drawn now.
+        bool shouldRender();
+        void frameRendered();
+
+        int getFramesRendered() const;
+        int getWakeups() const;
+        // Time spent blocked in waitForWork().
+        Uint32 getIdleMs() const;
+
+        void printStats() const;
+
+    private:
+        Uint32 mWakeEvent;
+        Uint32 mFrameInterval;
+        Uint32 mLastFrame;
+        Uint32 mWakeAt;
+        bool mHasWakeAt;
+        bool mDirty;
+
+        int mFramesRendered;
+        int mWakeups;
+        Uint32 mIdleMs;
+};
+
+#endif
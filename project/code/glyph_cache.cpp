@@ -0,0 +1,146 @@
+#include "glyph_cache.h"
+#include "alloc_tracker.h"
+
+#include <stdio.h>
+#include <string.h>
+
+GlyphCache::GlyphCache()
+{
+    mHasKerning = false;
+    mLineHeight = 0;
+    mReady = false;
+    memset(mGlyphs, 0, sizeof(mGlyphs));
+    memset(mKerning, 0, sizeof(mKerning));
+}
+
+GlyphCache::~GlyphCache()
+{
+    free();
+}
+
+bool GlyphCache::build(SDL_Renderer* renderer, TTF_Font* font)
+{
+    free();
+    mAtlas.init(512, 512, 1);
+    mLineHeight = TTF_FontLineSkip(font);
+
+    SDL_Color white = {0xFF, 0xFF, 0xFF, 0xFF};
+    for (int i = 0; i < GLYPH_COUNT; i++)
+    {
+        Uint16 ch = (Uint16) (GLYPH_FIRST + i);
+        Glyph& glyph = mGlyphs[i];
+        glyph.sprite = -1;
+        glyph.offsetX = 0;
+        glyph.advance = 0;
+
+        int minx, maxx, miny, maxy, advance;
+        if (TTF_GlyphMetrics(font, ch, &minx, &maxx, &miny, &maxy, &advance) != 0)
+        {
+            continue;
+        }
+        glyph.advance = advance;
+        if (maxx <= minx)
+        {
+            continue;
+        }
+
+        // The surface spans the full font height with the baseline at the
+        // ascent and starts at min(0, minx), like a one-character string
+        SDL_Surface* surface = TTF_RenderGlyph_Blended(font, ch, white);
+        if (surface == NULL)
+        {
+            continue;
+        }
+        glyph.sprite = mAtlas.add(surface, NULL);
+        glyph.offsetX = minx < 0 ? minx : 0;
+        SDL_FreeSurface(surface);
+    }
+
+    mHasKerning = TTF_GetFontKerning(font) != 0;
+    if (mHasKerning)
+    {
+        for (int a = 0; a < GLYPH_COUNT; a++)
+        {
+            for (int b = 0; b < GLYPH_COUNT; b++)
+            {
+                int kern = TTF_GetFontKerningSizeGlyphs(font, (Uint16) (GLYPH_FIRST + a), (Uint16) (GLYPH_FIRST + b));
+                mKerning[a][b] = (Sint8) SDL_max(-128, SDL_min(127, kern));
+            }
+        }
+    }
+
+    if (!mAtlas.upload(renderer))
+    {
+        free();
+        return false;
+    }
+    mReady = true;
+    return true;
+}
+
+void GlyphCache::free()
+{
+    mAtlas.free();
+    mReady = false;
+}
+
+int GlyphCache::layout(SpriteBatch* batch, int x, int y, const char* text, SDL_Color color)
+{
+    int penX = x;
+    int width = 0;
+    int prev = -1;
+    for (const char* c = text; *c != '\0'; c++)
+    {
+        if (*c == '\n')
+        {
+            width = SDL_max(width, penX - x);
+            penX = x;
+            y += mLineHeight;
+            prev = -1;
+            continue;
+        }
+
+        int index = (unsigned char) *c - GLYPH_FIRST;
+        if (index < 0 || index >= GLYPH_COUNT)
+        {
+            index = '?' - GLYPH_FIRST;
+        }
+        if (prev >= 0 && mHasKerning)
+        {
+            penX += mKerning[prev][index];
+        }
+
+        const Glyph& glyph = mGlyphs[index];
+        if (batch != NULL && glyph.sprite >= 0)
+        {
+            batch->draw(mAtlas.getSprite(glyph.sprite), penX + glyph.offsetX, y, color);
+        }
+        penX += glyph.advance;
+        prev = index;
+    }
+    return SDL_max(width, penX - x);
+}
+
+int GlyphCache::draw(SpriteBatch& batch, int x, int y, const char* text, SDL_Color color)
+{
+    ALLOC_SCOPE(ALLOC_SUBSYSTEM_TEXT);
+    if (!mReady)
+    {
+        return 0;
+    }
+    return layout(&batch, x, y, text, color);
+}
+
+int GlyphCache::measure(const char* text)
+{
+    SDL_Color color = {0, 0, 0, 0};
+    return layout(NULL, 0, 0, text, color);
+}
+
+int GlyphCache::getLineHeight() const {
+    return mLineHeight;
+}
+
+bool GlyphCache::isReady() const {
+    return mReady;
+}
@@ -0,0 +1,56 @@
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include "SDL.h"
+#include "SDL_ttf.h"
+
+#include "sprite_atlas.h"
+#include "sprite_batch.h"
+
+const int GLYPH_FIRST = 32;
+const int GLYPH_LAST = 126;
+const int GLYPH_COUNT = GLYPH_LAST - GLYPH_FIRST + 1;
+
+// Printable ASCII of one font at one size, rasterized once in white into an
+// atlas and tinted per draw. Drawing a string only queues quads on a
+// SpriteBatch: no surfaces, textures or heap allocations per call.
+class GlyphCache
+{
+    public:
+        GlyphCache();
+        ~GlyphCache();
+
+        bool build(SDL_Renderer* renderer, TTF_Font* font);
+        void free();
+
+        // Returns the width of the widest line drawn. '\n' starts a new line.
+        int draw(SpriteBatch& batch, int x, int y, const char* text, SDL_Color color);
+        int measure(const char* text);
+
+        int getLineHeight() const;
+        bool isReady() const;
+
+    private:
+        GlyphCache(const GlyphCache&);
+        GlyphCache& operator=(const GlyphCache&);
+
+        struct Glyph
+        {
+            // -1 for glyphs with no pixels, e.g. space
+            int sprite;
+            int offsetX;
+            int advance;
+        };
+
+        int layout(SpriteBatch* batch, int x, int y, const char* text, SDL_Color color);
+
+        SpriteAtlas mAtlas;
+        Glyph mGlyphs[GLYPH_COUNT];
+        // Pair kerning, looked up once at build time
+        Sint8 mKerning[GLYPH_COUNT][GLYPH_COUNT];
+        bool mHasKerning;
+        int mLineHeight;
+        bool mReady;
+};
+
+#endif
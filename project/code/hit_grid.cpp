@@ -0,0 +1,158 @@
+#include "hit_grid.h"
+
+HitGrid::HitGrid()
+{
+    mColumns = 0;
+    mRows = 0;
+    mCellSize = 1;
+}
+
+void HitGrid::init(int width, int height, int cellSize)
+{
+    clear();
+    mCellSize = cellSize > 0 ? cellSize : 1;
+    mColumns = (width + mCellSize - 1) / mCellSize;
+    mRows = (height + mCellSize - 1) / mCellSize;
+    if (mColumns < 1)
+    {
+        mColumns = 1;
+    }
+    if (mRows < 1)
+    {
+        mRows = 1;
+    }
+    mCells.assign(mColumns * mRows, std::vector<int>());
+}
+
+void HitGrid::clear()
+{
+    mX0.clear();
+    mY0.clear();
+    mX1.clear();
+    mY1.clear();
+    mUserdata.clear();
+    for (size_t i = 0; i < mCells.size(); i++)
+    {
+        mCells[i].clear();
+    }
+}
+
+int HitGrid::add(const SDL_Rect& bounds, void* userdata)
+{
+    int id = (int) mX0.size();
+    mX0.push_back(bounds.x);
+    mY0.push_back(bounds.y);
+    mX1.push_back(bounds.x + bounds.w);
+    mY1.push_back(bounds.y + bounds.h);
+    mUserdata.push_back(userdata);
+    insert(id);
+    return id;
+}
+
+void HitGrid::setBounds(int id, const SDL_Rect& bounds)
+{
+    erase(id);
+    mX0[id] = bounds.x;
+    mY0[id] = bounds.y;
+    mX1[id] = bounds.x + bounds.w;
+    mY1[id] = bounds.y + bounds.h;
+    insert(id);
+}
+
+// Ids stay valid, the widget just can't be hit any more.
+void HitGrid::remove(int id)
+{
+    erase(id);
+    mX1[id] = mX0[id];
+    mY1[id] = mY0[id];
+}
+
+int HitGrid::cellColumn(int x) const
+{
+    int column = x < 0 ? 0 : x / mCellSize;
+    return column < mColumns ? column : mColumns - 1;
+}
+
+int HitGrid::cellRow(int y) const
+{
+    int row = y < 0 ? 0 : y / mCellSize;
+    return row < mRows ? row : mRows - 1;
+}
+
+void HitGrid::insert(int id)
+{
+    if (mX1[id] <= mX0[id] || mY1[id] <= mY0[id])
+    {
+        return;
+    }
+    int c0 = cellColumn(mX0[id]);
+    int c1 = cellColumn(mX1[id] - 1);
+    int r0 = cellRow(mY0[id]);
+    int r1 = cellRow(mY1[id] - 1);
+    for (int r = r0; r <= r1; r++)
+    {
+        for (int c = c0; c <= c1; c++)
+        {
+            mCells[r * mColumns + c].push_back(id);
+        }
+    }
+}
+
+void HitGrid::erase(int id)
+{
+    if (mX1[id] <= mX0[id] || mY1[id] <= mY0[id])
+    {
+        return;
+    }
+    int c0 = cellColumn(mX0[id]);
+    int c1 = cellColumn(mX1[id] - 1);
+    int r0 = cellRow(mY0[id]);
+    int r1 = cellRow(mY1[id] - 1);
+    for (int r = r0; r <= r1; r++)
+    {
+        for (int c = c0; c <= c1; c++)
+        {
+            std::vector<int>& cell = mCells[r * mColumns + c];
+            for (size_t i = 0; i < cell.size(); i++)
+            {
+                if (cell[i] == id)
+                {
+                    cell[i] = cell.back();
+                    cell.pop_back();
+                    break;
+                }
+            }
+        }
+    }
+}
+
+int HitGrid::hitTest(int x, int y) const
+{
+    if (mCells.empty())
+    {
+        return -1;
+    }
+
+    // Cell lists lose their order on setBounds(), so take the highest id
+    const std::vector<int>& cell = mCells[cellRow(y) * mColumns + cellColumn(x)];
+    const int* ids = cell.data();
+    int count = (int) cell.size();
+    int hit = -1;
+    for (int i = 0; i < count; i++)
+    {
+        int id = ids[i];
+        if (id > hit && x >= mX0[id] && x < mX1[id] && y >= mY0[id] && y < mY1[id])
+        {
+            hit = id;
+        }
+    }
+    return hit;
+}
+
+void* HitGrid::getUserdata(int id) const {
+    return mUserdata[id];
+}
+
+int HitGrid::getCount() const {
+    return (int) mX0.size();
+}
@@ -0,0 +1,52 @@
+#ifndef HIT_GRID_H
+#define HIT_GRID_H
+
+#include "SDL.h"
+
+#include <vector>
+
+// Pointer hit testing for widgets. Bounds are kept as flat arrays, one per
+// edge, and every widget is listed in the cells of a uniform grid it
+// overlaps, so a lookup only tests the few widgets sharing the pointer's
+// cell instead of every widget on screen.
+class HitGrid
+{
+    public:
+        HitGrid();
+
+        // Widgets outside width x height still work, they just share the
+        // edge cells.
+        void init(int width, int height, int cellSize);
+        void clear();
+
+        // Returns the widget id. Later widgets are on top of earlier ones.
+        int add(const SDL_Rect& bounds, void* userdata);
+        void setBounds(int id, const SDL_Rect& bounds);
+        void remove(int id);
+
+        // Topmost widget containing (x, y), -1 for none.
+        int hitTest(int x, int y) const;
+
+        void* getUserdata(int id) const;
+        int getCount() const;
+
+    private:
+        int cellColumn(int x) const;
+        int cellRow(int y) const;
+        void insert(int id);
+        void erase(int id);
+
+        // Half-open bounds, [x0, x1) by [y0, y1)
+        std::vector<int> mX0;
+        std::vector<int> mY0;
+        std::vector<int> mX1;
+        std::vector<int> mY1;
+        std::vector<void*> mUserdata;
+
+        std::vector<std::vector<int> > mCells;
+        int mColumns;
+        int mRows;
+        int mCellSize;
+};
+
+#endif
@@ -0,0 +1,131 @@
+#include "hud.h"
+
+#include <string.h>
+
+static const int HUD_PADDING = 4;
+static const int HUD_GRAPH_HEIGHT = 32;
+// Top of the graph, twice a 60 Hz frame
+static const double HUD_GRAPH_MAX_MS = 33.3;
+static const double HUD_TARGET_MS = 1000.0 / 60.0;
+// Widest text the HUD formats, sizes the panel at build time
+static const char* HUD_WIDEST_TEXT = "000.00 ms  000 fps\n0000 draws  00 voices\n0000.0 MB  0000 allocs";
+
+PerfHud::PerfHud()
+{
+    mBounds.x = 0;
+    mBounds.y = 0;
+    mBounds.w = 0;
+    mBounds.h = 0;
+    mTextHeight = 0;
+    memset(&mStats, 0, sizeof(mStats));
+    mHistoryPos = 0;
+    mHistoryCount = 0;
+    mText[0] = '\0';
+    mVisible = false;
+}
+
+PerfHud::~PerfHud()
+{
+    free();
+}
+
+bool PerfHud::build(SDL_Renderer* renderer, TTF_Font* font)
+{
+    free();
+    if (!mGlyphs.build(renderer, font))
+    {
+        return false;
+    }
+    int textWidth = mGlyphs.measure(HUD_WIDEST_TEXT);
+    mTextHeight = mGlyphs.getLineHeight() * 3;
+    mBounds.w = (textWidth > HUD_HISTORY ? textWidth : HUD_HISTORY) + 2 * HUD_PADDING;
+    mBounds.h = mTextHeight + HUD_GRAPH_HEIGHT + 3 * HUD_PADDING;
+    return true;
+}
+
+void PerfHud::free(){
+    mGlyphs.free();
+    mBounds.w = 0;
+    mBounds.h = 0;
+}
+
+bool PerfHud::isReady() const {
+    return mGlyphs.isReady();
+}
+
+void PerfHud::setVisible(bool visible){
+    mVisible = visible;
+}
+
+bool PerfHud::isVisible() const {
+    return mVisible;
+}
+
+void PerfHud::toggle(){
+    mVisible = !mVisible;
+}
+
+void PerfHud::update(const HudStats& stats)
+{
+    mStats = stats;
+    mHistory[mHistoryPos] = (float) stats.frameMs;
+    mIntervals[mHistoryPos] = (float) stats.intervalMs;
+    mHistoryPos = (mHistoryPos + 1) % HUD_HISTORY;
+    if (mHistoryCount < HUD_HISTORY)
+    {
+        mHistoryCount++;
+    }
+}
+
+SDL_Rect PerfHud::getBounds() const {
+    return mBounds;
+}
+
+void PerfHud::draw(SDL_Renderer* renderer)
+{
+    if (!mVisible || !mGlyphs.isReady())
+    {
+        return;
+    }
+
+    SDL_BlendMode blendMode;
+    SDL_GetRenderDrawBlendMode(renderer, &blendMode);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0xB0);
+    SDL_RenderFillRect(renderer, &mBounds);
+
+    // FPS over the whole history, a single interval jitters too much to read
+    double intervalTotal = 0.0;
+    for (int i = 0; i < mHistoryCount; i++)
+    {
+        intervalTotal += mIntervals[i];
+    }
+    double fps = intervalTotal > 0.0 ? mHistoryCount * 1000.0 / intervalTotal : 0.0;
+    SDL_snprintf(mText, sizeof(mText), "%.2f ms  %.0f fps\n%d draws  %d voices\n%.1f MB  %d allocs", mStats.frameMs, fps,
+        mStats.drawCalls, mStats.voices, mStats.textureBytes / (1024.0 * 1024.0), mStats.allocations);
+    SDL_Color white = {0xFF, 0xFF, 0xFF, 0xFF};
+    mGlyphs.draw(mBatch, mBounds.x + HUD_PADDING, mBounds.y + HUD_PADDING, mText, white);
+    mBatch.flush(renderer);
+
+    // Oldest sample on the left, newest on the right
+    int graphBottom = mBounds.y + mBounds.h - HUD_PADDING;
+    int graphLeft = mBounds.x + mBounds.w - HUD_PADDING - mHistoryCount;
+    int oldest = (mHistoryPos - mHistoryCount + HUD_HISTORY) % HUD_HISTORY;
+    for (int i = 0; i < mHistoryCount; i++)
+    {
+        double ms = mHistory[(oldest + i) % HUD_HISTORY];
+        int h = (int) (ms * HUD_GRAPH_HEIGHT / HUD_GRAPH_MAX_MS);
+        mPoints[i].x = graphLeft + i;
+        mPoints[i].y = graphBottom - (h < HUD_GRAPH_HEIGHT ? h : HUD_GRAPH_HEIGHT);
+    }
+    int targetY = graphBottom - (int) (HUD_TARGET_MS * HUD_GRAPH_HEIGHT / HUD_GRAPH_MAX_MS);
+    SDL_SetRenderDrawColor(renderer, 0x60, 0x60, 0x60, 0xFF);
+    SDL_RenderDrawLine(renderer, mBounds.x + HUD_PADDING, targetY, mBounds.x + mBounds.w - HUD_PADDING, targetY);
+    if (mHistoryCount > 1)
+    {
+        SDL_SetRenderDrawColor(renderer, 0x40, 0xFF, 0x40, 0xFF);
+        SDL_RenderDrawLines(renderer, mPoints, mHistoryCount);
+    }
+
+    SDL_SetRenderDrawBlendMode(renderer, blendMode);
+}
@@ -0,0 +1,70 @@
+#ifndef HUD_H
+#define HUD_H
+
+#include "SDL.h"
+#include "SDL_ttf.h"
+
+#include "glyph_cache.h"
+#include "sprite_batch.h"
+
+// What the HUD shows, sampled once per rendered frame.
+struct HudStats
+{
+    // CPU time of the frame and time since the previous one
+    double frameMs;
+    double intervalMs;
+    int drawCalls;
+    size_t textureBytes;
+    int voices;
+    // Main thread heap allocations, see alloc_tracker.h
+    int allocations;
+};
+
+// Frame times kept for the graph, one pixel each
+const int HUD_HISTORY = 120;
+
+// Performance overlay in the top-left corner: the last frame's numbers and
+// a graph of recent frame times. Text comes from a glyph cache and the
+// graph is one SDL_RenderDrawLines strip, so a frame costs one fill, a few
+// dozen quads and two line calls, with no allocations.
+class PerfHud
+{
+    public:
+        PerfHud();
+        ~PerfHud();
+
+        bool build(SDL_Renderer* renderer, TTF_Font* font);
+        void free();
+        bool isReady() const;
+
+        void setVisible(bool visible);
+        bool isVisible() const;
+        void toggle();
+
+        void update(const HudStats& stats);
+
+        // Fixed while built, so it can be handed to damage tracking.
+        SDL_Rect getBounds() const;
+
+        void draw(SDL_Renderer* renderer);
+
+    private:
+        PerfHud(const PerfHud&);
+        PerfHud& operator=(const PerfHud&);
+
+        GlyphCache mGlyphs;
+        SpriteBatch mBatch;
+        SDL_Rect mBounds;
+        int mTextHeight;
+
+        HudStats mStats;
+        float mHistory[HUD_HISTORY];
+        float mIntervals[HUD_HISTORY];
+        int mHistoryPos;
+        int mHistoryCount;
+        SDL_Point mPoints[HUD_HISTORY];
+        char mText[128];
+        bool mVisible;
+};
+
+#endif
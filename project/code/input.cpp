@@ -0,0 +1,161 @@
+#include "input.h"
+#include "profiler.h"
+#include "alloc_tracker.h"
+
+#include <stdio.h>
+
+InputPump::InputPump()
+{
+    mHasPendingMotion = false;
+    mQuit = false;
+    mQueueDepth = 0;
+    mMaxQueueDepth = 0;
+    mDispatched = 0;
+    mCoalesced = 0;
+    mHasInput = false;
+    mOldestInput = 0;
+    mInputLatency = 0;
+    mMaxInputLatency = 0;
+}
+
+void InputPump::addHandler(Uint32 firstType, Uint32 lastType, InputHandler handler, void* userdata)
+{
+    Handler entry = {firstType, lastType, handler, userdata};
+    mHandlers.push_back(entry);
+}
+
+bool InputPump::pump()
+{
+    PROFILE_SCOPE("input");
+    ALLOC_SCOPE(ALLOC_SUBSYSTEM_INPUT);
+    mDispatched = 0;
+    mCoalesced = 0;
+
+    SDL_PumpEvents();
+    mQueueDepth = SDL_PeepEvents(NULL, 0, SDL_PEEKEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT);
+    if (mQueueDepth > mMaxQueueDepth)
+    {
+        mMaxQueueDepth = mQueueDepth;
+    }
+
+    const int batchSize = (int) (sizeof(mBatch) / sizeof(mBatch[0]));
+    for (;;)
+    {
+        int count = SDL_PeepEvents(mBatch, batchSize, SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT);
+        for (int i = 0; i < count; i++)
+        {
+            SDL_Event* e = &mBatch[i];
+            if (e->type != SDL_MOUSEMOTION)
+            {
+                flushMotion();
+                dispatch(e);
+                continue;
+            }
+
+            // A newer motion event supersedes the pending one, keep its
+            // position and add up the relative movement
+            if (mHasPendingMotion && mPendingMotion.motion.windowID == e->motion.windowID && mPendingMotion.motion.which == e->motion.which)
+            {
+                e->motion.xrel += mPendingMotion.motion.xrel;
+                e->motion.yrel += mPendingMotion.motion.yrel;
+                e->motion.timestamp = mPendingMotion.motion.timestamp;
+                mCoalesced++;
+            } else {
+                flushMotion();
+            }
+            mPendingMotion = *e;
+            mHasPendingMotion = true;
+        }
+        if (count < batchSize)
+        {
+            break;
+        }
+    }
+    flushMotion();
+
+    return !mQuit;
+}
+
+void InputPump::flushMotion()
+{
+    if (mHasPendingMotion)
+    {
+        mHasPendingMotion = false;
+        dispatch(&mPendingMotion);
+    }
+}
+
+void InputPump::dispatch(SDL_Event* e)
+{
+    if (e->type == SDL_QUIT)
+    {
+        mQuit = true;
+    }
+
+    // Coalesced motion keeps the timestamp of the first event it absorbed
+    if (e->type >= SDL_KEYDOWN && e->type < SDL_CLIPBOARDUPDATE)
+    {
+        if (!mHasInput || SDL_TICKS_PASSED(mOldestInput, e->common.timestamp))
+        {
+            mOldestInput = e->common.timestamp;
+        }
+        mHasInput = true;
+    }
+
+    for (size_t i = 0; i < mHandlers.size(); i++)
+    {
+        const Handler& h = mHandlers[i];
+        if (e->type >= h.firstType && e->type <= h.lastType)
+        {
+            h.handler(e, h.userdata);
+        }
+    }
+    mDispatched++;
+}
+
+void InputPump::markNotPresented(){
+    mHasInput = false;
+}
+
+void InputPump::markPresented()
+{
+    if (!mHasInput)
+    {
+        return;
+    }
+    mHasInput = false;
+    mInputLatency = SDL_GetTicks() - mOldestInput;
+    if (mInputLatency > mMaxInputLatency)
+    {
+        mMaxInputLatency = mInputLatency;
+    }
+}
+
+int InputPump::getQueueDepth() const {
+    return mQueueDepth;
+}
+
+int InputPump::getMaxQueueDepth() const {
+    return mMaxQueueDepth;
+}
+
+int InputPump::getDispatchedCount() const {
+    return mDispatched;
+}
+
+int InputPump::getCoalescedCount() const {
+    return mCoalesced;
+}
+
+Uint32 InputPump::getInputLatencyMs() const {
+    return mInputLatency;
+}
+
+Uint32 InputPump::getMaxInputLatencyMs() const {
+    return mMaxInputLatency;
+}
+
+void InputPump::printStats() const
+{
+    printf("input: max queue depth %d, input to present %u ms (max %u ms)\n", mMaxQueueDepth, mInputLatency, mMaxInputLatency);
+}
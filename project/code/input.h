@@ -0,0 +1,70 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include "SDL.h"
+
+#include <vector>
+
+typedef void (*InputHandler)(SDL_Event* e, void* userdata);
+
+// Drains the whole SDL event queue every frame in bulk with SDL_PeepEvents,
+// folds runs of mouse motion into one event, and hands everything to the
+// handlers registered for its type, in queue (timestamp) order.
+class InputPump
+{
+    public:
+        InputPump();
+
+        // handler gets every event with firstType <= type <= lastType.
+        void addHandler(Uint32 firstType, Uint32 lastType, InputHandler handler, void* userdata);
+
+        // Returns false once SDL_QUIT has been seen.
+        bool pump();
+
+        // Call right after SDL_RenderPresent to close the latency sample
+        // for the input handled this frame.
+        void markPresented();
+        // Call instead when the input handled this frame led to no present,
+        // so a later unrelated present isn't charged with it.
+        void markNotPresented();
+
+        // Events waiting in the queue at the start of the last pump().
+        int getQueueDepth() const;
+        int getMaxQueueDepth() const;
+        int getDispatchedCount() const;
+        int getCoalescedCount() const;
+        // Oldest input event handled in the last frame to its present, in ms.
+        Uint32 getInputLatencyMs() const;
+        Uint32 getMaxInputLatencyMs() const;
+
+        void printStats() const;
+
+    private:
+        struct Handler
+        {
+            Uint32 firstType;
+            Uint32 lastType;
+            InputHandler handler;
+            void* userdata;
+        };
+
+        void dispatch(SDL_Event* e);
+        void flushMotion();
+
+        std::vector<Handler> mHandlers;
+        SDL_Event mBatch[64];
+        SDL_Event mPendingMotion;
+        bool mHasPendingMotion;
+        bool mQuit;
+
+        int mQueueDepth;
+        int mMaxQueueDepth;
+        int mDispatched;
+        int mCoalesced;
+        bool mHasInput;
+        Uint32 mOldestInput;
+        Uint32 mInputLatency;
+        Uint32 mMaxInputLatency;
+};
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef LOCKFREE_QUEUE_H
+#define LOCKFREE_QUEUE_H
+
+#include "SDL_assert.h"
+#include "SDL_atomic.h"
+#include "SDL_stdinc.h"
+
+// Bounded multi-producer/multi-consumer queue (Vyukov). Every cell carries
+// a sequence number that tells producers and consumers whose turn it is, so
+// push and pop only ever CAS their own position counter. capacity must be a
+// power of two. push() fails when full and pop() when empty, neither blocks.
+template <typename T>
+class LockFreeQueue
+{
+    public:
+        explicit LockFreeQueue(int capacity);
+        ~LockFreeQueue();
+
+        bool push(const T& value);
+        bool pop(T* value);
+
+    private:
+        LockFreeQueue(const LockFreeQueue&);
+        LockFreeQueue& operator=(const LockFreeQueue&);
+
+        struct Cell
+        {
+            SDL_atomic_t sequence;
+            T value;
+        };
+
+        Cell* mCells;
+        int mMask;
+
+        // Keep the two hot counters on separate cache lines
+        char mPad0[64];
+        SDL_atomic_t mEnqueuePos;
+        char mPad1[64];
+        SDL_atomic_t mDequeuePos;
+        char mPad2[64];
+};
+
+template <typename T>
+LockFreeQueue<T>::LockFreeQueue(int capacity)
+{
+    SDL_assert(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+    mCells = new Cell[capacity];
+    mMask = capacity - 1;
+    for (int i = 0; i < capacity; i++)
+    {
+        SDL_AtomicSet(&mCells[i].sequence, i);
+    }
+    SDL_AtomicSet(&mEnqueuePos, 0);
+    SDL_AtomicSet(&mDequeuePos, 0);
+}
+
+template <typename T>
+LockFreeQueue<T>::~LockFreeQueue()
+{
+    delete [] mCells;
+}
+
+template <typename T>
+bool LockFreeQueue<T>::push(const T& value)
+{
+    Cell* cell;
+    int pos = SDL_AtomicGet(&mEnqueuePos);
+    for (;;)
+    {
+        cell = &mCells[pos & mMask];
+        int diff = SDL_AtomicGet(&cell->sequence) - pos;
+        if (diff == 0)
+        {
+            if (SDL_AtomicCAS(&mEnqueuePos, pos, pos + 1))
+            {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = SDL_AtomicGet(&mEnqueuePos);
+        }
+    }
+
+    cell->value = value;
+    SDL_AtomicSet(&cell->sequence, pos + 1);
+    return true;
+}
+
+template <typename T>
+bool LockFreeQueue<T>::pop(T* value)
+{
+    Cell* cell;
+    int pos = SDL_AtomicGet(&mDequeuePos);
+    for (;;)
+    {
+        cell = &mCells[pos & mMask];
+        int diff = SDL_AtomicGet(&cell->sequence) - (pos + 1);
+        if (diff == 0)
+        {
+            if (SDL_AtomicCAS(&mDequeuePos, pos, pos + 1))
+            {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = SDL_AtomicGet(&mDequeuePos);
+        }
+    }
+
+    *value = cell->value;
+    SDL_AtomicSet(&cell->sequence, pos + mMask + 1);
+    return true;
+}
+
+#endif
@@ -0,0 +1,246 @@
+#include "ltexture.h"
+#include "profiler.h"
+#include "alloc_tracker.h"
+
+#include <stdio.h>
+
+static int gTextureDrawCounts[LTEXTURE_DRAW_TOTAL];
+
+int getTextureDrawCount(LTextureDrawClass drawClass){
+    return gTextureDrawCounts[drawClass];
+}
+
+void resetTextureDrawCounts(){
+    for (int i = 0; i < LTEXTURE_DRAW_TOTAL; i++)
+    {
+        gTextureDrawCounts[i] = 0;
+    }
+}
+
+const char* getTextureDrawClassName(LTextureDrawClass drawClass)
+{
+    switch (drawClass)
+    {
+    case LTEXTURE_DRAW_BLIT:
+    return "blit";
+
+    case LTEXTURE_DRAW_SCALED:
+    return "scaled";
+
+    case LTEXTURE_DRAW_ROTATED:
+    return "rotated";
+
+    case LTEXTURE_DRAW_CULLED:
+    return "culled";
+
+    default:
+    return "unknown";
+    }
+}
+
+
+LTexture::LTexture()
+{
+    mTexture = NULL;
+    mCached = NULL;
+    mWidth = 0;
+    mHeight = 0;
+    mColor.r = 0xFF;
+    mColor.g = 0xFF;
+    mColor.b = 0xFF;
+    mColor.a = 0xFF;
+    mBlendMode = SDL_BLENDMODE_NONE;
+}
+
+LTexture::~LTexture()
+{
+    free();
+}
+
+bool LTexture::loadFromFile(const std::string& path)
+{
+    free();
+    SDL_Color colorKey = {0, 0xFF, 0xFF, 0xFF};
+    mCached = gTextureCache.acquire(path, &colorKey);
+    if (mCached == NULL)
+    {
+        printf("Unable to load texture from %s\n", path.c_str());
+        return false;
+    }
+
+    mTexture = mCached->texture;
+    mWidth = mCached->width;
+    mHeight = mCached->height;
+    mBlendMode = mCached->blendMode;
+    return true;
+}
+
+// Does not take ownership, the caller may keep using the surface.
+bool LTexture::loadFromSurface( SDL_Surface* surface)
+{
+    free();
+    SDL_SetColorKey(surface, SDL_TRUE, SDL_MapRGB(surface->format, 0, 0xFF, 0xFF));
+    mTexture = SDL_CreateTextureFromSurface(sdlRenderer, surface);
+    if (mTexture == NULL)
+    {
+        printf("Unable to create texture from surface, Error: %s\n", SDL_GetError());
+    } else {
+        mWidth = surface->w;
+        mHeight = surface->h;
+        SDL_GetTextureBlendMode(mTexture, &mBlendMode);
+    }
+
+    return mTexture != NULL;
+}
+
+#ifdef _SDL_TTF_H
+bool LTexture::loadFromRenderedText(const std::string& textureText, SDL_Color textColor){
+    ALLOC_SCOPE(ALLOC_SUBSYSTEM_TEXT);
+    free();
+    SDL_Surface* textSurface = TTF_RenderText_Solid( gFont, textureText.c_str(), textColor);
+    if (textSurface == NULL)
+    {
+        printf("Unable to render text surface. Error: %s\n", TTF_GetError());
+    } else {
+        mTexture = SDL_CreateTextureFromSurface(sdlRenderer, textSurface);
+        if (mTexture == NULL)
+        {
+            printf("Unable to create texture from text, Error %s\n", SDL_GetError());
+        } else {
+            mWidth = textSurface->w;
+            mHeight = textSurface->h;
+            SDL_GetTextureBlendMode(mTexture, &mBlendMode);
+        }
+
+        SDL_FreeSurface(textSurface);
+    }
+
+    return mTexture != NULL;
+}
+#endif
+
+void LTexture::free(){
+    if (mCached != NULL)
+    {
+        gTextureCache.release(mCached);
+        mCached = NULL;
+    } else if (mTexture != NULL) {
+        SDL_DestroyTexture(mTexture);
+    }
+    mTexture = NULL;
+    mWidth = 0;
+    mHeight = 0;
+}
+
+void LTexture::setColor(Uint8 red, Uint8 green, Uint8 blue){
+    mColor.r = red;
+    mColor.g = green;
+    mColor.b = blue;
+}
+
+void LTexture::setBlendMode(SDL_BlendMode blending){
+    mBlendMode = blending;
+}
+
+void LTexture::setAlpha(Uint8 alpha){
+    mColor.a = alpha;
+}
+
+void LTexture::render(int x, int y, SDL_Rect* clip, double angle, SDL_Point* center, SDL_RendererFlip flip){
+    SDL_Rect renderQuad = {x, y, mWidth, mHeight};
+    if (clip != NULL)
+    {
+        renderQuad.w = clip->w;
+        renderQuad.h = clip->h;
+    }
+    draw(clip, renderQuad, angle, center, flip);
+}
+
+void LTexture::render(const SDL_Rect& dst, SDL_Rect* clip){
+    draw(clip, dst, 0.0, NULL, SDL_FLIP_NONE);
+}
+
+LTextureDrawClass LTexture::classify(SDL_Rect* clip, const SDL_Rect& dst, double angle, SDL_RendererFlip flip){
+    // Only redrawing damaged rects, skip everything that misses them.
+    // Rotated quads cover more than dst, those are left to SDL.
+    SDL_Rect clipRect;
+    SDL_RenderGetClipRect(sdlRenderer, &clipRect);
+    LTextureDrawClass drawClass;
+    if (angle == 0.0 && !SDL_RectEmpty(&clipRect) && !SDL_HasIntersection(&clipRect, &dst))
+    {
+        drawClass = LTEXTURE_DRAW_CULLED;
+    } else if (angle != 0.0 || flip != SDL_FLIP_NONE) {
+        drawClass = LTEXTURE_DRAW_ROTATED;
+    } else {
+        int srcW = clip != NULL ? clip->w : mWidth;
+        int srcH = clip != NULL ? clip->h : mHeight;
+        drawClass = dst.w != srcW || dst.h != srcH ? LTEXTURE_DRAW_SCALED : LTEXTURE_DRAW_BLIT;
+    }
+    gTextureDrawCounts[drawClass]++;
+    return drawClass;
+}
+
+void LTexture::draw(SDL_Rect* clip, const SDL_Rect& dst, double angle, SDL_Point* center, SDL_RendererFlip flip){
+    PROFILE_SCOPE("LTexture::render");
+    // Still loading
+    if (mTexture == NULL)
+    {
+        return;
+    }
+    LTextureDrawClass drawClass = classify(clip, dst, angle, flip);
+    if (drawClass == LTEXTURE_DRAW_CULLED)
+    {
+        return;
+    }
+
+    SDL_SetTextureColorMod(mTexture, mColor.r, mColor.g, mColor.b);
+    SDL_SetTextureAlphaMod(mTexture, mColor.a);
+    SDL_SetTextureBlendMode(mTexture, mBlendMode);
+
+    if (drawClass == LTEXTURE_DRAW_ROTATED)
+    {
+        SDL_RenderCopyEx(sdlRenderer, mTexture, clip, &dst, angle, center, flip);
+        return;
+    }
+    SDL_RenderCopy(sdlRenderer, mTexture, clip, &dst);
+}
+
+void LTexture::render(SpriteBatch& batch, int x, int y, SDL_Rect* clip){
+    if (mTexture == NULL)
+    {
+        return;
+    }
+    SDL_Rect src = {0, 0, mWidth, mHeight};
+    if (clip != NULL)
+    {
+        src = *clip;
+    }
+    SDL_Rect dst = {x, y, src.w, src.h};
+    batch.draw(mTexture, src, dst, mColor, mBlendMode);
+}
+
+void LTexture::render(RenderQueue& queue, int layer, int x, int y, SDL_Rect* clip, double angle, SDL_Point* center, SDL_RendererFlip flip){
+    if (mTexture == NULL)
+    {
+        return;
+    }
+    SDL_Rect dst = {x, y, mWidth, mHeight};
+    if (clip != NULL)
+    {
+        dst.w = clip->w;
+        dst.h = clip->h;
+    }
+    if (classify(clip, dst, angle, flip) == LTEXTURE_DRAW_CULLED)
+    {
+        return;
+    }
+    queue.drawEx(layer, mTexture, clip, dst, angle, center, flip, mColor, mBlendMode);
+}
+
+int LTexture::getHeight(){
+    return mHeight;
+}
+
+int LTexture::getWidth(){
+    return mWidth;
+}
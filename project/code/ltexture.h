@@ -0,0 +1,89 @@
+#ifndef LTEXTURE_H
+#define LTEXTURE_H
+
+#include "SDL.h"
+#include "SDL_ttf.h"
+
+#include "texture_cache.h"
+#include "sprite_batch.h"
+#include "render_queue.h"
+
+#include <string>
+
+// Owned by the program that links LTexture in.
+extern SDL_Renderer* sdlRenderer;
+extern TextureCache gTextureCache;
+extern TTF_Font* gFont;
+
+// How a render() call was dispatched. Plain and scaled draws go through
+// SDL_RenderCopy; only rotated or flipped ones pay for SDL_RenderCopyEx,
+// which the software renderer sends through its rotozoom path. Draws that
+// fall outside the renderer's clip rect are culled before reaching SDL.
+enum LTextureDrawClass
+{
+    LTEXTURE_DRAW_BLIT = 0,
+    LTEXTURE_DRAW_SCALED = 1,
+    LTEXTURE_DRAW_ROTATED = 2,
+    LTEXTURE_DRAW_CULLED = 3,
+    LTEXTURE_DRAW_TOTAL = 4
+};
+
+int getTextureDrawCount(LTextureDrawClass drawClass);
+void resetTextureDrawCounts();
+const char* getTextureDrawClassName(LTextureDrawClass drawClass);
+
+class LTexture
+{
+    public:
+        LTexture();
+        ~LTexture();
+
+        bool loadFromFile(const std::string& path);
+
+        bool loadFromSurface( SDL_Surface* surface);
+
+        #ifdef _SDL_TTF_H
+        bool loadFromRenderedText(const std::string& textureText, SDL_Color textColor);
+        #endif
+
+        void free();
+
+        void setColor( Uint8 red, Uint8 green, Uint8 blue);
+
+        void setBlendMode( SDL_BlendMode blending);
+
+        void setAlpha( Uint8 alpha);
+
+        void render(int x, int y, SDL_Rect* clip = NULL, double angle = 0.0, SDL_Point* center = NULL, SDL_RendererFlip flip = SDL_FLIP_NONE);
+
+        // Stretches clip, or the whole texture, over dst.
+        void render(const SDL_Rect& dst, SDL_Rect* clip = NULL);
+
+        // Same as an unrotated render(), but queued on batch.
+        void render(SpriteBatch& batch, int x, int y, SDL_Rect* clip = NULL);
+
+        // Recorded on queue and drawn at its flush(), which has to run
+        // under the same clip rect.
+        void render(RenderQueue& queue, int layer, int x, int y, SDL_Rect* clip = NULL, double angle = 0.0, SDL_Point* center = NULL, SDL_RendererFlip flip = SDL_FLIP_NONE);
+
+        int getWidth();
+        int getHeight();
+
+    private:
+        SDL_Texture* mTexture;
+        // Set when mTexture is shared through gTextureCache
+        CachedTexture* mCached;
+        int mWidth;
+        int mHeight;
+
+        // Shared textures can't hold per-object state, so it is applied at render
+        SDL_Color mColor;
+        SDL_BlendMode mBlendMode;
+
+        // Counts the draw and returns its class, LTEXTURE_DRAW_CULLED if it
+        // should not be drawn at all.
+        LTextureDrawClass classify(SDL_Rect* clip, const SDL_Rect& dst, double angle, SDL_RendererFlip flip);
+        void draw(SDL_Rect* clip, const SDL_Rect& dst, double angle, SDL_Point* center, SDL_RendererFlip flip);
+};
+
+#endif
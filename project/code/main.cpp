@@ -2,15 +2,47 @@
 #include "SDL_image.h"
 #include "SDL_ttf.h"
 #include "SDL_mixer.h"
-#include "SDL_syswm.h"
 
-#include <windows.h>
-
-#include <sstream>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <string>
 #include <cmath>
 
+#include "profiler.cpp"
+#include "alloc_tracker.cpp"
+#include "frame_arena.cpp"
+#include "color_key_scan.cpp"
+#include "shape_mask.cpp"
+#include "shape_backend.cpp"
+#include "assets.cpp"
+#include "crc32.cpp"
+#include "mapped_file.cpp"
+#include "shape_cache.cpp"
+#include "texture_cache.cpp"
+#include "async_loader.cpp"
+#include "sprite_atlas.cpp"
+#include "sprite_batch.cpp"
+#include "render_queue.cpp"
+#include "ltexture.cpp"
+#include "glyph_cache.cpp"
+#include "input.cpp"
+#include "frame_scheduler.cpp"
+#include "damage.cpp"
+#include "hit_grid.cpp"
+#include "audio.cpp"
+#include "voices.cpp"
+#include "actions.cpp"
+#include "mix_kernels.cpp"
+#include "soft_mixer.cpp"
+#include "sound_bank.cpp"
+#include "music_stream.cpp"
+#include "hud.cpp"
+
+#ifndef _WIN32
+#define printf_s printf
+#endif
+
 #define SCREEN_HEIGHT 250
 #define SCREEN_WIDTH 250
 
@@ -18,17 +50,78 @@ const int BUTTON_WIDTH = 100;
 const int BUTTON_HEIGHT = 100;
 const int TOTAL_BUTTONS = 4;
 
+const size_t TEXTURE_BUDGET_BYTES = 32 * 1024 * 1024;
+// Time per frame the main thread may spend creating textures for loaded assets
+const double LOADER_PUMP_BUDGET_MS = 4.0;
+// Frame cap for renderers that could not get vsync
+const int MAX_FPS = 60;
+// Per buffer, the arena keeps two
+const size_t FRAME_ARENA_BYTES = 256 * 1024;
+
+// Overridden with -audio low|balanced|safe
+AudioLatencyProfile gRequestedAudioProfile = AUDIO_LATENCY_BALANCED;
+// Background track streamed with -music <file>
+const char* gMusicPath = NULL;
+const int MUSIC_READ_AHEAD_MS = 500;
+// Chrome trace written on exit with -trace <file>, internal builds only
+const char* gTracePath = NULL;
+
 SDL_Window *screen = NULL;
+ShapeBackend *gShapeBackend = NULL;
+// Set once the window has its shape from the mask cache
+bool gSkinShaped = false;
 SDL_Renderer * sdlRenderer = NULL;
+// Set when sdlRenderer draws straight into the window surface
+SDL_Window *gSurfaceWindow = NULL;
+AssetCache gAssets;
+TextureCache gTextureCache;
+AsyncLoader gLoader;
 TTF_Font *gFont = NULL;
-
-Mix_Music *gMusic = NULL;
+// Toggled with F3 or shown from the start with -hud. Its own small font,
+// gFont is too large for a 250 pixel window.
+PerfHud gHud;
+TTF_Font *gHudFont = NULL;
+const int HUD_FONT_SIZE = 12;
+// Keeps the HUD live while nothing else is drawing
+const Uint32 HUD_REFRESH_MS = 250;
+InputPump gInput;
+FrameScheduler gFrames;
+// Scratch memory for the frame being built, reset at every present
+FrameArena gFrameArena;
+// Texture draws of the scene, flushed per damaged rect
+RenderQueue gRenderQueue;
+DamageTracker gDamage;
+HitGrid gButtonHits;
+InputActions gActions;
+VoiceManager gVoices;
+// Enabled with -softmix, UI sounds then bypass the SDL_mixer channels
+SoftMixer gSoftMixer;
+bool gUseSoftMixer = false;
+SoftSound gScratchSound;
+
+// Pre-converted effects, see bankpack.cpp. Chunks taken from it belong to
+// the bank and are freed with it.
+SoundBank gSounds;
+
+MusicStream gMusic;
 
 Mix_Chunk *gScratch = NULL;
 Mix_Chunk *gHigh = NULL;
 Mix_Chunk *gMedium = NULL;
 Mix_Chunk *gLow = NULL;
 
+enum Action{
+    ACTION_SCRATCH_UP = 0,
+    ACTION_SCRATCH_DOWN = 1,
+    ACTION_SCRATCH_LEFT = 2,
+    ACTION_RESET_TIMER = 3,
+    ACTION_TOGGLE_HUD = 4
+};
+
+// Voices of the scratch sound allowed at once, more steal the oldest
+const int SCRATCH_POLYPHONY = 2;
+const int SOFT_MIXER_VOICES = 32;
+
 enum LButtonSprite{
     BUTTON_SPRITE_MOUSE_OUT = 0,
     BUTTON_SPRITE_MOUSE_OVER_MOTION = 1,
@@ -37,153 +130,23 @@ enum LButtonSprite{
     BUTTON_SPRITE_TOTAL = 4
 };
 
-class LTexture
-{
-    public:
-        LTexture();
-        ~LTexture();
-
-        bool loadFromFile( std::string path);
-
-        #ifdef _SDL_TTF_H
-        bool loadFromRenderedText( std::string textureText, SDL_Color textColor);
-        #endif
-
-        void free();
-
-        void setColor( Uint8 red, Uint8 green, Uint8 blue);
-
-        void setBlendMode( SDL_BlendMode blending);
-
-        void setAlpha( Uint8 alpha);
-
-        void render(int x, int y, SDL_Rect* clip = NULL, double angle = 0.0, SDL_Point* center = NULL, SDL_RendererFlip flip = SDL_FLIP_NONE);
-
-        int getWidth();
-        int getHeight();
-
-    private:
-        SDL_Texture* mTexture;
-        int mWidth;
-        int mHeight;
-};
-
-LTexture::LTexture()
-{
-    mTexture = NULL;
-    mWidth = 0;
-    mHeight = 0;
-}
-
-LTexture::~LTexture()
-{
-    free();
-}
-
-bool LTexture::loadFromFile( std::string path)
-{
-    free();
-    SDL_Texture* newTexture = NULL;
-    SDL_Surface* loadedSurface = IMG_Load(path.c_str());
-    if (loadedSurface == NULL)
-    {
-        printf_s("Unable to load image at %s, Error: %s", path.c_str(), IMG_GetError());
-    } else {
-        SDL_SetColorKey(loadedSurface, SDL_TRUE, SDL_MapRGB(loadedSurface->format, 0, 0xFF, 0xFF));
-    }
-    newTexture = SDL_CreateTextureFromSurface(sdlRenderer, loadedSurface);
-    if (newTexture == NULL)
-    {
-        printf_s("Unable to create texture from %s, Error: %s\n", path.c_str(), SDL_GetError());
-    } else {
-        mWidth = loadedSurface->w;
-        mHeight = loadedSurface->h;
-    }
-
-    SDL_FreeSurface( loadedSurface );
-
-    mTexture = newTexture;
-    return mTexture != NULL;
-}
-
-#ifdef _SDL_TTF_H
-bool LTexture::loadFromRenderedText( std::string textureText, SDL_Color textColor){
-    free();
-    SDL_Surface* textSurface = TTF_RenderText_Solid( gFont, textureText.c_str(), textColor);
-    if (textSurface == NULL)
-    {
-        printf_s("Unable to render text surface. Error: %s\n", TTF_GetError());
-    } else {
-        mTexture = SDL_CreateTextureFromSurface(sdlRenderer, textSurface);
-        if (mTexture == NULL)
-        {
-            printf_s("Unable to create texture from text, Error %s\n", SDL_GetError());
-        } else {
-            mWidth = textSurface->w;
-            mHeight = textSurface->h;
-        }
-
-        SDL_FreeSurface(textSurface);
-    }
-
-    return mTexture != NULL;
-}
-#endif
-
-void LTexture::free(){
-    if (mTexture != NULL)
-    {
-        SDL_DestroyTexture(mTexture);
-        mTexture = NULL;
-        mWidth = 0;
-        mHeight = 0;
-    }
-}
-
-void LTexture::setColor(Uint8 red, Uint8 green, Uint8 blue){
-    SDL_SetTextureColorMod(mTexture, red, green, blue);
-}
-
-void LTexture::setBlendMode(SDL_BlendMode blending){
-    SDL_SetTextureBlendMode(mTexture, blending);
-}
-
-void LTexture::setAlpha(Uint8 alpha){
-    SDL_SetTextureAlphaMod(mTexture, alpha);
-}
-
-void LTexture::render(int x, int y, SDL_Rect* clip, double angle, SDL_Point* center, SDL_RendererFlip flip){
-    SDL_Rect renderQuad = {x, y, mWidth, mHeight};
-    if (clip != NULL)
-    {
-        renderQuad.w = clip->w;
-        renderQuad.h = clip->h;
-    }
-    SDL_RenderCopyEx(sdlRenderer, mTexture, clip, &renderQuad, angle, center, flip);
-}
-
-int LTexture::getHeight(){
-    return mHeight;
-}
-
-int LTexture::getWidth(){
-    return mWidth;
-}
-
 class LButton
 {
     public:
         LButton();
 
+        // Also places the button in gButtonHits
         void setPosition(int x, int y);
 
-        void handleEvent(SDL_Event* e);
+        // inside comes from the hit test on the event's own coordinates.
+        void handleEvent(SDL_Event* e, bool inside);
 
         void render();
 
     private:
         SDL_Point mPosition;
         LButtonSprite mCurrentSprite;
+        int mHitId;
 };
 
 LButton::LButton()
@@ -191,38 +154,27 @@ LButton::LButton()
     mPosition.x = 0;
     mPosition.y = 0;
     mCurrentSprite = BUTTON_SPRITE_MOUSE_OUT;
+    mHitId = -1;
 }
 
 void LButton::setPosition(int x, int y){
     mPosition.x = x;
     mPosition.y = y;
+
+    SDL_Rect bounds = {x, y, BUTTON_WIDTH, BUTTON_HEIGHT};
+    if (mHitId < 0)
+    {
+        mHitId = gButtonHits.add(bounds, this);
+    } else {
+        gButtonHits.setBounds(mHitId, bounds);
+    }
 }
 
-void LButton::handleEvent( SDL_Event* e)
+void LButton::handleEvent( SDL_Event* e, bool inside)
 {
     if (e->type == SDL_MOUSEMOTION || e->type == SDL_MOUSEBUTTONDOWN || e->type == SDL_MOUSEBUTTONUP)
     {
-        int x, y;
-        SDL_GetMouseState( &x, &y);
-
-        bool inside = true;
-
-        if (x < mPosition.x)
-        {
-            inside = false;
-        }
-        else if(x > mPosition.x + BUTTON_WIDTH)
-        {
-            inside = false;
-        }
-        else if(y < mPosition.y)
-        {
-            inside = false;
-        }
-        else if (y > mPosition.y + BUTTON_HEIGHT)
-        {
-            inside = false;
-        }
+        LButtonSprite previousSprite = mCurrentSprite;
 
         if (!inside)
         {
@@ -244,6 +196,13 @@ void LButton::handleEvent( SDL_Event* e)
             break;
             }
         }
+
+        if (mCurrentSprite != previousSprite)
+        {
+            SDL_Rect area = {mPosition.x, mPosition.y, BUTTON_WIDTH, BUTTON_HEIGHT};
+            gDamage.add(area);
+            gFrames.markDirty();
+        }
     }
 }
 
@@ -254,6 +213,35 @@ LTexture gTexture;
 LTexture gBackgroundTexture;
 LTexture gTextTexture;
 
+LButton* gHoveredButton = NULL;
+
+// One grid lookup per event; only the button under the pointer and the one
+// it just left need to hear about it.
+void handleButtonEvent(SDL_Event* e, void* userdata){
+    int x = e->type == SDL_MOUSEMOTION ? e->motion.x : e->button.x;
+    int y = e->type == SDL_MOUSEMOTION ? e->motion.y : e->button.y;
+    int hit = gButtonHits.hitTest(x, y);
+    LButton* button = hit >= 0 ? (LButton*) gButtonHits.getUserdata(hit) : NULL;
+
+    if (gHoveredButton != NULL && gHoveredButton != button)
+    {
+        gHoveredButton->handleEvent(e, false);
+    }
+    if (button != NULL)
+    {
+        button->handleEvent(e, true);
+    }
+    gHoveredButton = button;
+}
+
+void handleWindowEvent(SDL_Event* e, void* userdata){
+    if (e->window.event == SDL_WINDOWEVENT_EXPOSED || e->window.event == SDL_WINDOWEVENT_SIZE_CHANGED || e->window.event == SDL_WINDOWEVENT_RESTORED)
+    {
+        gDamage.addAll();
+        gFrames.markDirty();
+    }
+}
+
 void LButton::render(){
     gTexture.render(mPosition.x, mPosition.y, &gSpriteClips[ mCurrentSprite]);
 }
@@ -266,7 +254,27 @@ bool init(){
         printf_s("error initializing");
         return false;
     }
-    screen = SDL_CreateWindow("My first window", SDL_WINDOWPOS_UNDEFINED, 1080 - SCREEN_HEIGHT, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_SWSURFACE | SDL_WINDOW_ALWAYS_ON_TOP | SDL_WINDOW_BORDERLESS | SDL_WINDOW_SKIP_TASKBAR);
+    Uint32 windowFlags = SDL_SWSURFACE | SDL_WINDOW_ALWAYS_ON_TOP | SDL_WINDOW_BORDERLESS | SDL_WINDOW_SKIP_TASKBAR;
+    gShapeBackend = createShapeBackend(SHAPE_BACKEND_SDL);
+    screen = gShapeBackend->createWindow("My first window", SDL_WINDOWPOS_UNDEFINED, 1080 - SCREEN_HEIGHT, SCREEN_WIDTH, SCREEN_HEIGHT, windowFlags);
+#ifdef _WIN32
+    if (screen == NULL)
+    {
+        printf_s("Shaped window unavailable, falling back to window regions. error: %s\n", SDL_GetError());
+        delete gShapeBackend;
+        gShapeBackend = createShapeBackend(SHAPE_BACKEND_WIN32_REGION);
+        screen = gShapeBackend->createWindow("My first window", SDL_WINDOWPOS_UNDEFINED, 1080 - SCREEN_HEIGHT, SCREEN_WIDTH, SCREEN_HEIGHT, windowFlags);
+    }
+#endif
+    if (screen == NULL)
+    {
+        // Wayland, X servers without XShape and the dummy driver have no
+        // shaped windows, a plain rectangular one still runs everything else
+        printf_s("Shaped window unavailable, using a plain window. error: %s\n", SDL_GetError());
+        delete gShapeBackend;
+        gShapeBackend = NULL;
+        screen = SDL_CreateWindow("My first window", SDL_WINDOWPOS_UNDEFINED, 1080 - SCREEN_HEIGHT, SCREEN_WIDTH, SCREEN_HEIGHT, windowFlags);
+    }
     if (screen == NULL)
     {
         printf_s("Window could not be created. error: %s\n", SDL_GetError());
@@ -274,10 +282,30 @@ bool init(){
     }
     sdlRenderer = SDL_CreateRenderer(screen, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
     if (sdlRenderer == NULL)
+    {
+        // Headless and VM hosts, draw into the window surface so only the
+        // damaged parts of it have to be pushed each frame
+        printf_s("No accelerated renderer, using the window surface. error: %s\n", SDL_GetError());
+        SDL_Surface* windowSurface = SDL_GetWindowSurface(screen);
+        if (windowSurface != NULL)
+        {
+            sdlRenderer = SDL_CreateSoftwareRenderer(windowSurface);
+            gSurfaceWindow = screen;
+        }
+    }
+    if (sdlRenderer == NULL)
     {
         printf_s("Renderer could not be created. error: %s\n", SDL_GetError());
         return false;
     }
+    gDamage.init(SCREEN_WIDTH, SCREEN_HEIGHT, gSurfaceWindow != NULL);
+    SDL_RendererInfo rendererInfo;
+    if (SDL_GetRendererInfo(sdlRenderer, &rendererInfo) == 0 && !(rendererInfo.flags & SDL_RENDERER_PRESENTVSYNC))
+    {
+        gFrames.setMaxFps(MAX_FPS);
+    }
+    gTextureCache.init(sdlRenderer, &gAssets);
+    gTextureCache.setBudget(TEXTURE_BUDGET_BYTES);
     //SDL_SetRenderDrawColor(sdlRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
 
     int imgFlags = IMG_INIT_PNG;
@@ -291,159 +319,203 @@ bool init(){
         printf_s("TTF could not initialize, Error %s\n",TTF_GetError());
         return false;
     }
-    if (Mix_OpenAudio( 44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0)
+    if (!openAudio(gRequestedAudioProfile))
     {
         printf_s("error initializing audio");
         return false;
     }
+    gVoices.init();
+    if (gUseSoftMixer)
+    {
+        Uint16 format;
+        int channels;
+        int frequency;
+        Mix_QuerySpec(&frequency, &format, &channels);
+        if (format == AUDIO_S16SYS && channels == 2 && gSoftMixer.init(frequency, SOFT_MIXER_VOICES, selectMixKernelPath()))
+        {
+            setAudioPostMix(SoftMixer::postMix, &gSoftMixer);
+            printf_s("Software mixer on, %s kernels\n", getMixKernelPathName(gSoftMixer.getPath()));
+        } else {
+            printf_s("Software mixer needs 16-bit stereo output, using SDL_mixer channels\n");
+            gUseSoftMixer = false;
+        }
+    }
+    if (!gLoader.start(&gAssets, 0))
+    {
+        printf_s("Asset loader could not be started\n");
+        return false;
+    }
+    if (gFrames.init())
+    {
+        gLoader.setWakeEventType(gFrames.getWakeEventType());
+    }
     return true;
 }
 
-bool loadMedia(){
-    bool success = true;
-
-    gFont = TTF_OpenFont("OpenSans-Regular.ttf", 28);
+void onFontLoaded(AsyncRequest* request, void* userdata){
+    gFont = request->font;
     if (gFont == NULL)
     {
-        printf_s("Failed to load font, Error %s\n", TTF_GetError());
-        success = false;
-    } else {
-        SDL_Color textColor = {0,0,0,255};
-        if (!gTextTexture.loadFromRenderedText("Press enter to reset start time.", textColor)){
-            printf_s("Failed to render text texture\n");
-            success = false;
-        }
+        printf_s("Failed to load font\n");
+        return;
+    }
+
+    SDL_Color textColor = {0,0,0,255};
+    if (!gTextTexture.loadFromRenderedText("Press enter to reset start time.", textColor)){
+        printf_s("Failed to render text texture\n");
     }
+}
+
+void setScratchChunk(Mix_Chunk* chunk){
+    gScratch = chunk;
+    gVoices.setPolyphony(gScratch, SCRATCH_POLYPHONY);
 
-    gScratch = Mix_LoadWAV("wololo.wav");
-    if (gScratch == NULL)
+    // Chunks are already converted to the device format
+    gScratchSound.format = SOFT_SAMPLE_S16;
+    gScratchSound.samples = gScratch->abuf;
+    gScratchSound.frames = gScratch->alen / (2 * sizeof(Sint16));
+}
+
+void onHudFontLoaded(AsyncRequest* request, void* userdata){
+    gHudFont = request->font;
+    if (gHudFont == NULL || !gHud.build(sdlRenderer, gHudFont))
+    {
+        printf_s("Failed to build HUD\n");
+    }
+}
+
+void onChunkLoaded(AsyncRequest* request, void* userdata){
+    if (request->chunk == NULL)
     {
         printf_s("failed loading woololo");
-        success = false;
+        return;
     }
+    setScratchChunk(request->chunk);
+}
 
+void onSkinLoaded(AsyncRequest* request, void* userdata){
+    if (request->surface == NULL)
+    {
+        printf_s("failed load skin\n");
+        return;
+    }
 
-    if (!gTexture.loadFromFile("hello.bmp"))
+    // The decoded skin is in gAssets now, the texture only uploads it and
+    // the shape mask, unless it came from the cache, reads the same pixels
+    if (!gTexture.loadFromFile(request->path))
     {
         printf_s("failed load sprites");
-        success = false;
     } else {
         gTexture.setBlendMode(SDL_BLENDMODE_BLEND);
     }
 
-    LPCSTR lpcstr = "hello.bmp";
-
-    HBITMAP hBmp = (HBITMAP) LoadImage(GetModuleHandle(NULL), lpcstr, IMAGE_BITMAP, 0, 0, LR_LOADFROMFILE);
-    if (!hBmp)
+    if (gSkinShaped || gShapeBackend == NULL)
     {
-        printf_s("could not load hBmp\n");
-        success = false;
+        return;
     }
-
-    BITMAP bm;
-    GetObject(hBmp, sizeof(bm), &bm);
-    int width(bm.bmWidth), height(bm.bmHeight);
-
-    BITMAPINFOHEADER bminfoheader;
-    ::ZeroMemory(&bminfoheader, sizeof(BITMAPINFOHEADER));
-    bminfoheader.biSize = sizeof(BITMAPINFOHEADER);
-    bminfoheader.biWidth       = width;
-    bminfoheader.biHeight      = -height;
-    bminfoheader.biPlanes      = 1;
-    bminfoheader.biBitCount    = 32;
-    bminfoheader.biCompression = BI_RGB;
-    bminfoheader.biSizeImage = width * 4 * height;
-    bminfoheader.biClrUsed = 0;
-    bminfoheader.biClrImportant = 0;
-
-    unsigned char* pPixels = new unsigned char[(width * 4 * height)];
-    if( !GetDIBits(CreateCompatibleDC(0), hBmp, 0, height, pPixels, (BITMAPINFO*) &bminfoheader, DIB_RGB_COLORS)) // load pixel info 
-    { 
-    //return if fails but first delete the resources
-    DeleteObject(hBmp);
-    delete [] pPixels; // delete the array of objects
-
-    return false;
+    ShapeMask skinMask;
+    if (buildShapeMaskCached(request->path, request->surface, skinMask) && gShapeBackend->setShapeMask(skinMask))
+    {
+        printf_s("window shaped with %s, scanned mask\n", gShapeBackend->getName());
     }
+}
 
-    HRGN hRgn, hRgnTemp;
-    COLORREF mask_color;
-
-    int x = 0, y = 0; // fill the x and y coordinate
+// Queues everything on the loader and returns right away, the callbacks
+// run from gLoader.pump() in the main loop.
+bool loadMedia(){
+    bool success = true;
 
-    unsigned char r = pPixels[(width*y+x) * 4 + 2];
-    unsigned char g = pPixels[(width*y+x) * 4 + 1];
-    unsigned char b = pPixels[(width*y+x) * 4 + 0]; 
+    success = gLoader.loadFont("OpenSans-Regular.ttf", 28, onFontLoaded, NULL) && success;
+    success = gLoader.loadFont("OpenSans-Regular.ttf", HUD_FONT_SIZE, onHudFontLoaded, NULL) && success;
+    // The bank only fits if the device kept the spec it was packed for,
+    // otherwise fall back to decoding the wav
+    Uint64 bankStart = SDL_GetPerformanceCounter();
+    if (gSounds.open("sounds.bank") && gSounds.getChunk("scratch") != NULL)
+    {
+        setScratchChunk(gSounds.getChunk("scratch"));
+        gHigh = gSounds.getChunk("high");
+        gMedium = gSounds.getChunk("medium");
+        gLow = gSounds.getChunk("low");
+        printf_s("sound bank: %d sounds in %.3f ms\n", gSounds.getCount(),
+            (double) (SDL_GetPerformanceCounter() - bankStart) * 1000.0 / (double) SDL_GetPerformanceFrequency());
+    } else {
+        gSounds.close();
+        success = gLoader.loadChunk("wololo.wav", onChunkLoaded, NULL) && success;
+    }
 
-    mask_color = RGB(r,g,b);
+    // A cached mask shapes the window before the skin is even decoded
+    ShapeMask skinMask;
+    if (gShapeBackend != NULL && loadCachedShapeMask("hello.bmp", skinMask) && gShapeBackend->setShapeMask(skinMask))
+    {
+        gSkinShaped = true;
+        printf_s("window shaped with %s, cached mask\n", gShapeBackend->getName());
+    }
+    success = gLoader.loadImage("hello.bmp", onSkinLoaded, NULL) && success;
 
-    hRgn = CreateRectRgn(0,0, width, height);
-    for (x = 0; x < width; x++)
+    if (gMusicPath != NULL)
     {
-        for (y = 0; y < height; y++)
+        gMusic.setReadAheadMs(MUSIC_READ_AHEAD_MS);
+        if (gMusic.open(gMusicPath))
         {
-            r = pPixels[(width*y+x) * 4 + 2];
-            g = pPixels[(width*y+x) * 4 + 1];
-            b = pPixels[(width*y+x) * 4 + 0]; 
-
-            if (RGB(r,g,b) == mask_color)
+            if (!gMusic.usesMixerMusic())
             {
-                hRgnTemp = CreateRectRgn(x,y, x+1,y+1);
-                CombineRgn(hRgn, hRgn, hRgnTemp, RGN_DIFF);
-                DeleteObject(hRgnTemp);
+                setAudioMusicSource(MusicStream::mixSource, &gMusic);
             }
+            gMusic.play(true);
+        } else {
+            success = false;
         }
     }
 
-//clean up the bitmap and buffer unless you still need it
-    DeleteObject(hBmp);
-    delete [] pPixels; // delete the array of objects
-
-    SDL_SysWMinfo wmInfo;
-    SDL_VERSION(&wmInfo.version);
-    SDL_GetWindowWMInfo(screen, &wmInfo);
-    HWND hwnd = wmInfo.info.win.window;
-    if (hwnd != NULL)
-    {
-        printf_s("got window handle\n");
-        
-        BOOL bRedraw = true;
-        SetWindowRgn(hwnd, hRgn, bRedraw);
-    }
-
     return success;
 }
 
 void close(){
-    Mix_FreeChunk(gScratch);
-    Mix_FreeChunk(gHigh);
-    Mix_FreeChunk(gMedium);
-    Mix_FreeChunk(gLow);
+    gLoader.stop();
+    // Soft voices may still point into the chunks
+    setAudioPostMix(NULL, NULL);
+    setAudioMusicSource(NULL, NULL);
+    gMusic.close();
+
+    if (gSounds.getCount() == 0)
+    {
+        Mix_FreeChunk(gScratch);
+        Mix_FreeChunk(gHigh);
+        Mix_FreeChunk(gMedium);
+        Mix_FreeChunk(gLow);
+    }
+    gSounds.close();
 
     gScratch = NULL;
     gHigh = NULL;
     gMedium = NULL;
     gLow = NULL;
 
-    Mix_FreeMusic(gMusic);
-    gMusic = NULL;
-
     gBackgroundTexture.free();
     gTexture.free();
     gTextTexture.free();
+    gHud.free();
+    gFrameArena.free();
+    TTF_CloseFont(gHudFont);
+    gHudFont = NULL;
+    gTextureCache.clear();
+    gAssets.clear();
     TTF_CloseFont(gFont);
     gFont = NULL;
     SDL_DestroyRenderer(sdlRenderer);
     SDL_DestroyWindow(screen);
     sdlRenderer = NULL;
     screen = NULL;
+    delete gShapeBackend;
+    gShapeBackend = NULL;
+    closeAudio();
     Mix_Quit();
     TTF_Quit();
     SDL_Quit();
     IMG_Quit();
 }
 
-SDL_Texture* loadTexture(std::string path){
+SDL_Texture* loadTexture(const std::string& path){
     SDL_Texture* newTexture = NULL;
 
     newTexture = IMG_LoadTexture(sdlRenderer, path.c_str());
@@ -451,8 +523,58 @@ SDL_Texture* loadTexture(std::string path){
     return newTexture;
 }
 
+int countTextureDraws(){
+    return getTextureDrawCount(LTEXTURE_DRAW_BLIT) + getTextureDrawCount(LTEXTURE_DRAW_SCALED) + getTextureDrawCount(LTEXTURE_DRAW_ROTATED);
+}
+
+// Called once per damaged rect with the renderer clipped to area.
+void drawScene(const SDL_Rect& area, void* userdata){
+    // SDL_RenderClear ignores the clip rect
+    {
+        PROFILE_SCOPE("clear");
+        SDL_SetRenderDrawColor(sdlRenderer, 0xFF, 0xFF, 0xFF, 0x0F);
+        SDL_RenderFillRect(sdlRenderer, &area);
+    }
+
+    //SDL_Rect* currentClip = &gSpriteClips[frame / 4];
+    //gTexture.render((SCREEN_WIDTH - currentClip->w) / 2, (SCREEN_HEIGHT - currentClip->h)/2, currentClip);
+    //gTexture.render(0,0,&gSpriteClips[sprite]);
+    //gTexture.render((SCREEN_WIDTH - gTexture.getWidth()) / 2, 0);
+    //gTextTexture.render((SCREEN_WIDTH - gTexture.getWidth())/2, (SCREEN_HEIGHT - gTexture.getHeight() ) / 2);
+    //gTexture.render(-8,-31);
+    gTexture.render(gRenderQueue, RENDER_LAYER_SCENE, 0, 0);
+    gRenderQueue.flush(sdlRenderer);
+}
+
 int main(int argc, char* args[])
 {
+    installAllocTracking();
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(args[i], "-audio") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (!parseAudioLatencyProfile(args[i], &gRequestedAudioProfile))
+            {
+                printf_s("Unknown audio profile %s, use low, balanced or safe\n", args[i]);
+            }
+        } else if (strcmp(args[i], "-softmix") == 0) {
+            gUseSoftMixer = true;
+        } else if (strcmp(args[i], "-music") == 0 && i + 1 < argc) {
+            i++;
+            gMusicPath = args[i];
+        } else if (strcmp(args[i], "-allocbudget") == 0 && i + 1 < argc) {
+            i++;
+            setAllocFrameBudget(atoi(args[i]));
+        } else if (strcmp(args[i], "-hud") == 0) {
+            gHud.setVisible(true);
+        } else if (strcmp(args[i], "-trace") == 0 && i + 1 < argc) {
+            i++;
+            gTracePath = args[i];
+        }
+    }
+
     if (init())
     {
         printf_s("Initialized SDL.\n");
@@ -463,77 +585,153 @@ int main(int argc, char* args[])
 
     if (loadMedia())
     {
-        printf_s("Loaded media.\n");
+        printf_s("Queued media.\n");
     } else {
-        printf_s("Failed loading media files.\n");
+        printf_s("Failed queueing media files.\n");
+    }
+    gFrameArena.init(FRAME_ARENA_BYTES);
+    gRenderQueue.init(&gFrameArena);
+
+    // One button in each corner
+    gButtonHits.init(SCREEN_WIDTH, SCREEN_HEIGHT, BUTTON_WIDTH / 2);
+    for (int i = 0; i < TOTAL_BUTTONS; i++)
+    {
+        gButtons[i].setPosition((i % 2) * (SCREEN_WIDTH - BUTTON_WIDTH), (i / 2) * (SCREEN_HEIGHT - BUTTON_HEIGHT));
     }
+    gInput.addHandler(SDL_MOUSEMOTION, SDL_MOUSEBUTTONUP, handleButtonEvent, NULL);
+    gInput.addHandler(SDL_WINDOWEVENT, SDL_WINDOWEVENT, handleWindowEvent, NULL);
+
+    gActions.bind(ACTION_SCRATCH_UP, SDL_SCANCODE_UP);
+    gActions.bind(ACTION_SCRATCH_DOWN, SDL_SCANCODE_DOWN);
+    gActions.bind(ACTION_SCRATCH_LEFT, SDL_SCANCODE_LEFT);
+    gActions.bind(ACTION_RESET_TIMER, SDL_SCANCODE_KP_ENTER);
+    gActions.bind(ACTION_TOGGLE_HUD, SDL_SCANCODE_F3);
+    gInput.addHandler(SDL_KEYDOWN, SDL_KEYUP, InputActions::handleEvent, &gActions);
 
     LButtonSprite sprite = BUTTON_SPRITE_MOUSE_DOWN;
     Uint32 startTime = 0;
+    bool mediaLoaded = false;
+    Uint64 lastFrameEnd = 0;
 
+    PROFILE_THREAD("main");
     while (1){
+        // Closes the previous iteration, so its "frame" scope is in it
+        PROFILE_FRAME();
+        allocEndFrame();
+        PROFILE_SCOPE("frame");
 
-        SDL_Color textColor = {0, 0, 0, 255};
-        
-        std::stringstream timeText;
+        gFrames.waitForWork();
+        if (!gInput.pump())
+        {
+            break;
+        }
 
-        SDL_Event e;
-        if (SDL_PollEvent(&e))
+        if (gLoader.pump(LOADER_PUMP_BUDGET_MS) > 0)
         {
-            if (e.type == SDL_QUIT)
+            gDamage.addAll();
+            gFrames.markDirty();
+        }
+        if (!mediaLoaded && gLoader.isIdle())
+        {
+            mediaLoaded = true;
+            printf_s("Loaded media.\n");
+            gAssets.printTimings();
+            gTextureCache.printStats();
+            setAllocSteadyState(true);
+        }
+
+        {
+            PROFILE_SCOPE("actions");
+            // Sounds only start on the press, holding a key costs nothing
+            if (gActions.wasPressed(ACTION_SCRATCH_UP) || gActions.wasPressed(ACTION_SCRATCH_DOWN) || gActions.wasPressed(ACTION_SCRATCH_LEFT))
+            {
+                if (gUseSoftMixer)
+                {
+                    gSoftMixer.play(&gScratchSound, 1.0f, 0.0f, false);
+                } else {
+                    gVoices.play(gScratch, 0);
+                }
+            }
+            if (gActions.wasPressed(ACTION_RESET_TIMER))
             {
-                break;
-            } else if (e.type == SDL_KEYDOWN)
+                startTime = SDL_GetTicks();
+            }
+            if (gActions.wasPressed(ACTION_TOGGLE_HUD))
             {
-                
+                gHud.toggle();
+                gDamage.add(gHud.getBounds());
+                gFrames.markDirty();
             }
+            gActions.endFrame();
         }
-    
-        const Uint8* currentKeyStates = SDL_GetKeyboardState( NULL );
-        if (currentKeyStates[SDL_SCANCODE_UP])
+
+        if (gActions.isDown(ACTION_SCRATCH_UP))
         {
             sprite = BUTTON_SPRITE_MOUSE_OUT;
-            Mix_PlayChannel(-1, gScratch, 0);
-        } else if (currentKeyStates[SDL_SCANCODE_DOWN])
+        } else if (gActions.isDown(ACTION_SCRATCH_DOWN))
         {
             sprite = BUTTON_SPRITE_MOUSE_OVER_MOTION;
-            Mix_PlayChannel(-1, gScratch, 0);
-        } else if (currentKeyStates[SDL_SCANCODE_LEFT])
+        } else if (gActions.isDown(ACTION_SCRATCH_LEFT))
         {
             sprite = BUTTON_SPRITE_MOUSE_UP;
-            Mix_PlayChannel(-1, gScratch, 0);
-        } else if (currentKeyStates[SDL_SCANCODE_KP_ENTER])
+        } else if (!gActions.isDown(ACTION_RESET_TIMER))
         {
-            startTime = SDL_GetTicks();
-        } 
-        else {
             sprite = BUTTON_SPRITE_MOUSE_DOWN;
         }
 
-        //timeText.str("");
-        //timeText << "Milliseconds since start time " << SDL_GetTicks() - startTime;
-
-
-        //if (!gTexture.loadFromRenderedText(timeText.str().c_str(), textColor))
-        //{
-        //    printf_s("cannot render text");
-        //}
-
-        SDL_SetRenderDrawColor(sdlRenderer, 0xFF, 0xFF, 0xFF, 0x0F);
-        SDL_RenderClear(sdlRenderer);
-        
-        
-        //SDL_Rect* currentClip = &gSpriteClips[frame / 4];
-        //gTexture.render((SCREEN_WIDTH - currentClip->w) / 2, (SCREEN_HEIGHT - currentClip->h)/2, currentClip);
-        //gTexture.render(0,0,&gSpriteClips[sprite]);
-        //gTexture.render((SCREEN_WIDTH - gTexture.getWidth()) / 2, 0);
-        //gTextTexture.render((SCREEN_WIDTH - gTexture.getWidth())/2, (SCREEN_HEIGHT - gTexture.getHeight() ) / 2);
-        //gTexture.render(-8,-31);
-        gTexture.render(0,0);
+        if (!gFrames.shouldRender())
+        {
+            gInput.markNotPresented();
+            continue;
+        }
 
-        SDL_RenderPresent(sdlRenderer);
+        Uint64 frameStart = SDL_GetPerformanceCounter();
+        int drawsBefore = countTextureDraws();
+        if (gHud.isVisible())
+        {
+            gDamage.add(gHud.getBounds());
+        }
+        gDamage.redraw(sdlRenderer, drawScene, NULL);
+        gRenderQueue.endFrame();
+        gHud.draw(sdlRenderer);
+        gDamage.present(sdlRenderer, gSurfaceWindow);
+        gFrameArena.endFrame();
+        gInput.markPresented();
+        gFrames.frameRendered();
+
+        // Shown on the next frame, so the HUD's own drawing is counted too
+        Uint64 frameEnd = SDL_GetPerformanceCounter();
+        if (gHud.isVisible())
+        {
+            double ticksPerMs = (double) SDL_GetPerformanceFrequency() / 1000.0;
+            HudStats stats;
+            stats.frameMs = (double) (frameEnd - frameStart) / ticksPerMs;
+            stats.intervalMs = lastFrameEnd != 0 ? (double) (frameEnd - lastFrameEnd) / ticksPerMs : 0.0;
+            stats.drawCalls = countTextureDraws() - drawsBefore;
+            stats.textureBytes = gTextureCache.getResidentBytes();
+            stats.voices = gVoices.getActiveVoices() + (gUseSoftMixer ? gSoftMixer.getActiveVoices() : 0);
+            AllocFrameStats allocStats;
+            getAllocFrameStats(&allocStats);
+            stats.allocations = allocStats.allocations;
+            gHud.update(stats);
+            gFrames.scheduleAt(SDL_GetTicks() + HUD_REFRESH_MS);
+        }
+        lastFrameEnd = frameEnd;
     }
 
+    gInput.printStats();
+    gFrames.printStats();
+    printAudioStats();
+    gVoices.printStats();
+    gMusic.printStats();
+    gFrameArena.printStats();
+    printAllocStats();
+    if (gTracePath != NULL && writeChromeTrace(gTracePath))
+    {
+        printf_s("trace written to %s\n", gTracePath);
+    }
 
+    // Unhooks the audio callbacks before the globals they use are destroyed
+    close();
     return 0;
 }
\ No newline at end of file
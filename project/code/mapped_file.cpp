@@ -0,0 +1,130 @@
+#include "mapped_file.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+    mData = NULL;
+    mSize = 0;
+#ifdef _WIN32
+    mFile = INVALID_HANDLE_VALUE;
+    mMapping = NULL;
+#else
+    mFd = -1;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const char* path)
+{
+    close();
+    mFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (mFile == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+    {
+        close();
+        return false;
+    }
+
+    mMapping = CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mMapping == NULL)
+    {
+        close();
+        return false;
+    }
+
+    mData = (const Uint8*) MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+    if (mData == NULL)
+    {
+        close();
+        return false;
+    }
+    mSize = (size_t) size.QuadPart;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (mData != NULL)
+    {
+        UnmapViewOfFile(mData);
+        mData = NULL;
+    }
+    if (mMapping != NULL)
+    {
+        CloseHandle(mMapping);
+        mMapping = NULL;
+    }
+    if (mFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(mFile);
+        mFile = INVALID_HANDLE_VALUE;
+    }
+    mSize = 0;
+}
+#else
+bool MappedFile::open(const char* path)
+{
+    close();
+    mFd = ::open(path, O_RDONLY);
+    if (mFd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(mFd, &st) != 0 || st.st_size == 0)
+    {
+        close();
+        return false;
+    }
+
+    void* data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, mFd, 0);
+    if (data == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+    mData = (const Uint8*) data;
+    mSize = (size_t) st.st_size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (mData != NULL)
+    {
+        munmap((void*) mData, mSize);
+        mData = NULL;
+    }
+    if (mFd >= 0)
+    {
+        ::close(mFd);
+        mFd = -1;
+    }
+    mSize = 0;
+}
+#endif
+
+const Uint8* MappedFile::getData() const {
+    return mData;
+}
+
+size_t MappedFile::getSize() const {
+    return mSize;
+}
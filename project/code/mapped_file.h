@@ -0,0 +1,39 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include "SDL_stdinc.h"
+
+#include <stddef.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Read-only memory mapping of a whole file.
+class MappedFile
+{
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        bool open(const char* path);
+        void close();
+
+        const Uint8* getData() const;
+        size_t getSize() const;
+
+    private:
+        MappedFile(const MappedFile&);
+        MappedFile& operator=(const MappedFile&);
+
+        const Uint8* mData;
+        size_t mSize;
+#ifdef _WIN32
+        HANDLE mFile;
+        HANDLE mMapping;
+#else
+        int mFd;
+#endif
+};
+
+#endif
@@ -0,0 +1,313 @@
+#include "mix_kernels.h"
+
+#include "SDL_cpuinfo.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MIX_KERNELS_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MIX_TARGET_SSE2 __attribute__((target("sse2")))
+#define MIX_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define MIX_TARGET_SSE2
+#define MIX_TARGET_AVX2
+#endif
+
+// Every path works out the gain of frame i as gain + i * step and resolves
+// with the same float ops, so they all produce the same samples. A running
+// gain += step would drift differently per lane width.
+static void mixAccumulateS16ScalarFrom(float* accum, const Sint16* src, int first, int frames, float gainL, float gainR, float stepL, float stepR)
+{
+    for (int i = first; i < frames; i++)
+    {
+        accum[i * 2] += src[i * 2] * (gainL + (float) i * stepL);
+        accum[i * 2 + 1] += src[i * 2 + 1] * (gainR + (float) i * stepR);
+    }
+}
+
+static void mixAccumulateF32ScalarFrom(float* accum, const float* src, int first, int frames, float gainL, float gainR, float stepL, float stepR)
+{
+    for (int i = first; i < frames; i++)
+    {
+        accum[i * 2] += src[i * 2] * (gainL + (float) i * stepL);
+        accum[i * 2 + 1] += src[i * 2 + 1] * (gainR + (float) i * stepR);
+    }
+}
+
+static void mixAccumulateS16Scalar(float* accum, const Sint16* src, int frames, float gainL, float gainR, float stepL, float stepR)
+{
+    mixAccumulateS16ScalarFrom(accum, src, 0, frames, gainL, gainR, stepL, stepR);
+}
+
+static void mixAccumulateF32Scalar(float* accum, const float* src, int frames, float gainL, float gainR, float stepL, float stepR)
+{
+    mixAccumulateF32ScalarFrom(accum, src, 0, frames, gainL, gainR, stepL, stepR);
+}
+
+// Rounds half away from zero: add +-0.5, clamp, truncate.
+static void mixResolveS16Scalar(Sint16* out, const float* accum, int samples)
+{
+    for (int i = 0; i < samples; i++)
+    {
+        float value = out[i] + accum[i];
+        value += value < 0.0f ? -0.5f : 0.5f;
+        if (value > 32767.0f)
+        {
+            value = 32767.0f;
+        } else if (value < -32768.0f) {
+            value = -32768.0f;
+        }
+        out[i] = (Sint16) value;
+    }
+}
+
+#ifdef MIX_KERNELS_X86
+// 4 frames per iteration, lanes hold L0 R0 L1 R1 and L2 R2 L3 R3. The
+// frame numbers of the lanes are kept as floats, exact well past any
+// buffer size.
+MIX_TARGET_SSE2
+static void mixAccumulateS16SSE2From(float* accum, const Sint16* src, int first, int frames, float gainL, float gainR, float stepL, float stepR)
+{
+    const __m128 gain = _mm_setr_ps(gainL, gainR, gainL, gainR);
+    const __m128 step = _mm_setr_ps(stepL, stepR, stepL, stepR);
+    const __m128 four = _mm_set1_ps(4.0f);
+    __m128 f01 = _mm_setr_ps((float) first, (float) first, (float) (first + 1), (float) (first + 1));
+    __m128 f23 = _mm_add_ps(f01, _mm_set1_ps(2.0f));
+
+    int i = first;
+    for (; i + 4 <= frames; i += 4)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i*) (src + i * 2));
+        __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16));
+        __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16));
+        __m128 g01 = _mm_add_ps(gain, _mm_mul_ps(f01, step));
+        __m128 g23 = _mm_add_ps(gain, _mm_mul_ps(f23, step));
+
+        float* a = accum + i * 2;
+        _mm_storeu_ps(a, _mm_add_ps(_mm_loadu_ps(a), _mm_mul_ps(lo, g01)));
+        _mm_storeu_ps(a + 4, _mm_add_ps(_mm_loadu_ps(a + 4), _mm_mul_ps(hi, g23)));
+
+        f01 = _mm_add_ps(f01, four);
+        f23 = _mm_add_ps(f23, four);
+    }
+    mixAccumulateS16ScalarFrom(accum, src, i, frames, gainL, gainR, stepL, stepR);
+}
+
+MIX_TARGET_SSE2
+static void mixAccumulateF32SSE2From(float* accum, const float* src, int first, int frames, float gainL, float gainR, float stepL, float stepR)
+{
+    const __m128 gain = _mm_setr_ps(gainL, gainR, gainL, gainR);
+    const __m128 step = _mm_setr_ps(stepL, stepR, stepL, stepR);
+    const __m128 four = _mm_set1_ps(4.0f);
+    __m128 f01 = _mm_setr_ps((float) first, (float) first, (float) (first + 1), (float) (first + 1));
+    __m128 f23 = _mm_add_ps(f01, _mm_set1_ps(2.0f));
+
+    int i = first;
+    for (; i + 4 <= frames; i += 4)
+    {
+        const float* s = src + i * 2;
+        float* a = accum + i * 2;
+        __m128 g01 = _mm_add_ps(gain, _mm_mul_ps(f01, step));
+        __m128 g23 = _mm_add_ps(gain, _mm_mul_ps(f23, step));
+        _mm_storeu_ps(a, _mm_add_ps(_mm_loadu_ps(a), _mm_mul_ps(_mm_loadu_ps(s), g01)));
+        _mm_storeu_ps(a + 4, _mm_add_ps(_mm_loadu_ps(a + 4), _mm_mul_ps(_mm_loadu_ps(s + 4), g23)));
+
+        f01 = _mm_add_ps(f01, four);
+        f23 = _mm_add_ps(f23, four);
+    }
+    mixAccumulateF32ScalarFrom(accum, src, i, frames, gainL, gainR, stepL, stepR);
+}
+
+MIX_TARGET_SSE2
+static void mixAccumulateS16SSE2(float* accum, const Sint16* src, int frames, float gainL, float gainR, float stepL, float stepR)
+{
+    mixAccumulateS16SSE2From(accum, src, 0, frames, gainL, gainR, stepL, stepR);
+}
+
+MIX_TARGET_SSE2
+static void mixAccumulateF32SSE2(float* accum, const float* src, int frames, float gainL, float gainR, float stepL, float stepR)
+{
+    mixAccumulateF32SSE2From(accum, src, 0, frames, gainL, gainR, stepL, stepR);
+}
+
+// 8 samples per iteration, the scalar steps lane-wise. Clamping before the
+// truncating convert keeps it in int32 range; packs then can't saturate.
+MIX_TARGET_SSE2
+static void mixResolveS16SSE2(Sint16* out, const float* accum, int samples)
+{
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 high = _mm_set1_ps(32767.0f);
+    const __m128 low = _mm_set1_ps(-32768.0f);
+
+    int i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i* o = (__m128i*) (out + i);
+        __m128i s = _mm_loadu_si128(o);
+        __m128 lo = _mm_add_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16)), _mm_loadu_ps(accum + i));
+        __m128 hi = _mm_add_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16)), _mm_loadu_ps(accum + i + 4));
+        // 0.5 - 1 where negative
+        lo = _mm_add_ps(lo, _mm_sub_ps(half, _mm_and_ps(_mm_cmplt_ps(lo, zero), one)));
+        hi = _mm_add_ps(hi, _mm_sub_ps(half, _mm_and_ps(_mm_cmplt_ps(hi, zero), one)));
+        lo = _mm_min_ps(_mm_max_ps(lo, low), high);
+        hi = _mm_min_ps(_mm_max_ps(hi, low), high);
+        _mm_storeu_si128(o, _mm_packs_epi32(_mm_cvttps_epi32(lo), _mm_cvttps_epi32(hi)));
+    }
+    if (i < samples)
+    {
+        mixResolveS16Scalar(out + i, accum + i, samples - i);
+    }
+}
+
+// 8 frames per iteration, same lane layout as SSE2 at twice the width.
+MIX_TARGET_AVX2
+static void mixAccumulateS16AVX2(float* accum, const Sint16* src, int frames, float gainL, float gainR, float stepL, float stepR)
+{
+    const __m256 gain = _mm256_setr_ps(gainL, gainR, gainL, gainR, gainL, gainR, gainL, gainR);
+    const __m256 step = _mm256_setr_ps(stepL, stepR, stepL, stepR, stepL, stepR, stepL, stepR);
+    const __m256 eight = _mm256_set1_ps(8.0f);
+    __m256 f03 = _mm256_setr_ps(0.0f, 0.0f, 1.0f, 1.0f, 2.0f, 2.0f, 3.0f, 3.0f);
+    __m256 f47 = _mm256_add_ps(f03, _mm256_set1_ps(4.0f));
+
+    int i = 0;
+    for (; i + 8 <= frames; i += 8)
+    {
+        __m128i s0 = _mm_loadu_si128((const __m128i*) (src + i * 2));
+        __m128i s1 = _mm_loadu_si128((const __m128i*) (src + i * 2 + 8));
+        __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(s0));
+        __m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(s1));
+        __m256 g03 = _mm256_add_ps(gain, _mm256_mul_ps(f03, step));
+        __m256 g47 = _mm256_add_ps(gain, _mm256_mul_ps(f47, step));
+
+        float* a = accum + i * 2;
+        _mm256_storeu_ps(a, _mm256_add_ps(_mm256_loadu_ps(a), _mm256_mul_ps(lo, g03)));
+        _mm256_storeu_ps(a + 8, _mm256_add_ps(_mm256_loadu_ps(a + 8), _mm256_mul_ps(hi, g47)));
+
+        f03 = _mm256_add_ps(f03, eight);
+        f47 = _mm256_add_ps(f47, eight);
+    }
+    mixAccumulateS16SSE2From(accum, src, i, frames, gainL, gainR, stepL, stepR);
+}
+
+MIX_TARGET_AVX2
+static void mixAccumulateF32AVX2(float* accum, const float* src, int frames, float gainL, float gainR, float stepL, float stepR)
+{
+    const __m256 gain = _mm256_setr_ps(gainL, gainR, gainL, gainR, gainL, gainR, gainL, gainR);
+    const __m256 step = _mm256_setr_ps(stepL, stepR, stepL, stepR, stepL, stepR, stepL, stepR);
+    const __m256 eight = _mm256_set1_ps(8.0f);
+    __m256 f03 = _mm256_setr_ps(0.0f, 0.0f, 1.0f, 1.0f, 2.0f, 2.0f, 3.0f, 3.0f);
+    __m256 f47 = _mm256_add_ps(f03, _mm256_set1_ps(4.0f));
+
+    int i = 0;
+    for (; i + 8 <= frames; i += 8)
+    {
+        const float* s = src + i * 2;
+        float* a = accum + i * 2;
+        __m256 g03 = _mm256_add_ps(gain, _mm256_mul_ps(f03, step));
+        __m256 g47 = _mm256_add_ps(gain, _mm256_mul_ps(f47, step));
+        _mm256_storeu_ps(a, _mm256_add_ps(_mm256_loadu_ps(a), _mm256_mul_ps(_mm256_loadu_ps(s), g03)));
+        _mm256_storeu_ps(a + 8, _mm256_add_ps(_mm256_loadu_ps(a + 8), _mm256_mul_ps(_mm256_loadu_ps(s + 8), g47)));
+
+        f03 = _mm256_add_ps(f03, eight);
+        f47 = _mm256_add_ps(f47, eight);
+    }
+    mixAccumulateF32SSE2From(accum, src, i, frames, gainL, gainR, stepL, stepR);
+}
+
+// 16 samples per iteration, same steps as SSE2. packs works per 128-bit
+// lane, the permute puts the four quarters back in order.
+MIX_TARGET_AVX2
+static void mixResolveS16AVX2(Sint16* out, const float* accum, int samples)
+{
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 high = _mm256_set1_ps(32767.0f);
+    const __m256 low = _mm256_set1_ps(-32768.0f);
+
+    int i = 0;
+    for (; i + 16 <= samples; i += 16)
+    {
+        __m128i* o = (__m128i*) (out + i);
+        __m256 lo = _mm256_add_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(o))), _mm256_loadu_ps(accum + i));
+        __m256 hi = _mm256_add_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(o + 1))), _mm256_loadu_ps(accum + i + 8));
+        lo = _mm256_add_ps(lo, _mm256_sub_ps(half, _mm256_and_ps(_mm256_cmp_ps(lo, zero, _CMP_LT_OQ), one)));
+        hi = _mm256_add_ps(hi, _mm256_sub_ps(half, _mm256_and_ps(_mm256_cmp_ps(hi, zero, _CMP_LT_OQ), one)));
+        lo = _mm256_min_ps(_mm256_max_ps(lo, low), high);
+        hi = _mm256_min_ps(_mm256_max_ps(hi, low), high);
+        __m256i packed = _mm256_packs_epi32(_mm256_cvttps_epi32(lo), _mm256_cvttps_epi32(hi));
+        _mm256_storeu_si256((__m256i*) o, _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    if (i < samples)
+    {
+        mixResolveS16SSE2(out + i, accum + i, samples - i);
+    }
+}
+#endif
+
+bool getMixKernels(MixKernelPath path, MixKernels* kernels)
+{
+    switch (path)
+    {
+    case MIX_KERNEL_SCALAR:
+    kernels->accumulateS16 = mixAccumulateS16Scalar;
+    kernels->accumulateF32 = mixAccumulateF32Scalar;
+    kernels->resolveS16 = mixResolveS16Scalar;
+    return true;
+
+#ifdef MIX_KERNELS_X86
+    case MIX_KERNEL_SSE2:
+    kernels->accumulateS16 = mixAccumulateS16SSE2;
+    kernels->accumulateF32 = mixAccumulateF32SSE2;
+    kernels->resolveS16 = mixResolveS16SSE2;
+    return true;
+
+    case MIX_KERNEL_AVX2:
+    kernels->accumulateS16 = mixAccumulateS16AVX2;
+    kernels->accumulateF32 = mixAccumulateF32AVX2;
+    kernels->resolveS16 = mixResolveS16AVX2;
+    return true;
+#endif
+
+    default:
+    return false;
+    }
+}
+
+MixKernelPath selectMixKernelPath()
+{
+#ifdef MIX_KERNELS_X86
+    if (SDL_HasAVX2())
+    {
+        return MIX_KERNEL_AVX2;
+    }
+    if (SDL_HasSSE2())
+    {
+        return MIX_KERNEL_SSE2;
+    }
+#endif
+    return MIX_KERNEL_SCALAR;
+}
+
+const char* getMixKernelPathName(MixKernelPath path)
+{
+    switch (path)
+    {
+    case MIX_KERNEL_SCALAR:
+    return "scalar";
+
+    case MIX_KERNEL_SSE2:
+    return "sse2";
+
+    case MIX_KERNEL_AVX2:
+    return "avx2";
+
+    default:
+    return "unknown";
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef MIX_KERNELS_H
+#define MIX_KERNELS_H
+
+#include "SDL_stdinc.h"
+
+enum MixKernelPath
+{
+    MIX_KERNEL_SCALAR = 0,
+    MIX_KERNEL_SSE2 = 1,
+    MIX_KERNEL_AVX2 = 2,
+    MIX_KERNEL_TOTAL = 3
+};
+
+// Inner loops of the software mixer. Voices are interleaved stereo and are
+// summed into a float accumulator in 16-bit sample units. Gains move
+// linearly from gainL/gainR by stepL/stepR every frame, so volume and pan
+// changes ramp instead of stepping.
+typedef void (*MixAccumulateS16Func)(float* accum, const Sint16* src, int frames, float gainL, float gainR, float stepL, float stepR);
+// Float sources are in [-1, 1], scale the gains by 32767.
+typedef void (*MixAccumulateF32Func)(float* accum, const float* src, int frames, float gainL, float gainR, float stepL, float stepR);
+// out[i] = out[i] + accum[i], rounded and saturated to 16 bits.
+typedef void (*MixResolveS16Func)(Sint16* out, const float* accum, int samples);
+
+struct MixKernels
+{
+    MixAccumulateS16Func accumulateS16;
+    MixAccumulateF32Func accumulateF32;
+    MixResolveS16Func resolveS16;
+};
+
+// Returns false if the path was not compiled in for this target.
+bool getMixKernels(MixKernelPath path, MixKernels* kernels);
+
+// Widest path the running CPU supports, via SDL_HasAVX2/SDL_HasSSE2.
+MixKernelPath selectMixKernelPath();
+
+const char* getMixKernelPathName(MixKernelPath path);
+
+#endif
@@ -0,0 +1,548 @@
+#include "music_stream.h"
+#include "audio.h"
+#include "profiler.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Bytes taken from the decoder per step
+static const int MUSIC_READ_BYTES = 16 * 1024;
+static const int MUSIC_MIN_RING_BYTES = 4096;
+
+class WavMusicDecoder : public MusicDecoder
+{
+    public:
+        WavMusicDecoder()
+        {
+            mSrc = NULL;
+            mDataStart = 0;
+            mDataBytes = 0;
+            mRemaining = 0;
+            mBlockAlign = 1;
+        }
+
+        virtual bool open(SDL_RWops* src, SDL_AudioSpec* spec)
+        {
+            mSrc = src;
+            Uint32 riff = SDL_ReadLE32(src);
+            SDL_ReadLE32(src);
+            if (riff != 0x46464952 || SDL_ReadLE32(src) != 0x45564157)
+            {
+                return false;
+            }
+
+            bool haveFormat = false;
+            for (;;)
+            {
+                Uint32 id = SDL_ReadLE32(src);
+                Uint32 size = SDL_ReadLE32(src);
+                if (id == 0)
+                {
+                    return false;
+                }
+                Sint64 next = SDL_RWtell(src) + size + (size & 1);
+
+                if (id == 0x20746D66) // fmt
+                {
+                    Uint16 tag = SDL_ReadLE16(src);
+                    spec->channels = (Uint8) SDL_ReadLE16(src);
+                    spec->freq = (int) SDL_ReadLE32(src);
+                    SDL_ReadLE32(src);
+                    mBlockAlign = SDL_ReadLE16(src);
+                    Uint16 bits = SDL_ReadLE16(src);
+                    if (tag == 0xFFFE && size >= 40)
+                    {
+                        // WAVE_FORMAT_EXTENSIBLE keeps the real tag in the sub format
+                        SDL_ReadLE16(src);
+                        SDL_ReadLE16(src);
+                        SDL_ReadLE32(src);
+                        tag = SDL_ReadLE16(src);
+                    }
+                    if (tag == 1 && bits == 8)
+                    {
+                        spec->format = AUDIO_U8;
+                    } else if (tag == 1 && bits == 16) {
+                        spec->format = AUDIO_S16LSB;
+                    } else if (tag == 1 && bits == 32) {
+                        spec->format = AUDIO_S32LSB;
+                    } else if (tag == 3 && bits == 32) {
+                        spec->format = AUDIO_F32LSB;
+                    } else {
+                        printf("wav stream: unsupported format %d, %d bits\n", tag, bits);
+                        return false;
+                    }
+                    haveFormat = spec->channels > 0 && spec->freq > 0 && mBlockAlign > 0;
+                } else if (id == 0x61746164) { // data
+                    mDataStart = SDL_RWtell(src);
+                    mDataBytes = size;
+                    mRemaining = size;
+                    return haveFormat;
+                }
+
+                if (SDL_RWseek(src, next, RW_SEEK_SET) < 0)
+                {
+                    return false;
+                }
+            }
+        }
+
+        virtual int read(Uint8* buffer, int bytes)
+        {
+            Uint32 want = (Uint32) bytes - (Uint32) bytes % mBlockAlign;
+            if (want > mRemaining)
+            {
+                want = mRemaining;
+            }
+            if (want == 0)
+            {
+                return 0;
+            }
+            size_t got = SDL_RWread(mSrc, buffer, 1, want);
+            if (got == 0)
+            {
+                return -1;
+            }
+            got -= got % mBlockAlign;
+            mRemaining -= (Uint32) got;
+            return (int) got;
+        }
+
+        virtual bool rewind()
+        {
+            mRemaining = mDataBytes;
+            return SDL_RWseek(mSrc, mDataStart, RW_SEEK_SET) >= 0;
+        }
+
+        virtual const char* getName()
+        {
+            return "wav";
+        }
+
+    private:
+        SDL_RWops* mSrc;
+        Sint64 mDataStart;
+        Uint32 mDataBytes;
+        Uint32 mRemaining;
+        Uint32 mBlockAlign;
+};
+
+MusicDecoder* createMusicDecoder(SDL_RWops* src)
+{
+    Uint8 magic[12];
+    Sint64 start = SDL_RWtell(src);
+    size_t got = SDL_RWread(src, magic, 1, sizeof(magic));
+    SDL_RWseek(src, start, RW_SEEK_SET);
+    if (got < sizeof(magic))
+    {
+        return NULL;
+    }
+
+    if (memcmp(magic, "RIFF", 4) == 0 && memcmp(magic + 8, "WAVE", 4) == 0)
+    {
+        return new WavMusicDecoder();
+    }
+
+    return NULL;
+}
+
+static const char* getMixerMusicTypeName(Mix_MusicType type)
+{
+    switch (type)
+    {
+    case MUS_WAV:
+    return "wav";
+
+    case MUS_MOD:
+    return "mod";
+
+    case MUS_MID:
+    return "midi";
+
+    case MUS_OGG:
+    return "ogg";
+
+    case MUS_MP3:
+    return "mp3";
+
+    case MUS_FLAC:
+    return "flac";
+
+    default:
+    return "unknown";
+    }
+}
+
+MusicStream::MusicStream()
+{
+    mDecoder = NULL;
+    mMusic = NULL;
+    mSrc = NULL;
+    mConverter = NULL;
+    mThread = NULL;
+    mSpaceFreed = NULL;
+    mRingMask = 0;
+    mDecoderDone = false;
+    SDL_AtomicSet(&mReadPos, 0);
+    SDL_AtomicSet(&mWritePos, 0);
+    SDL_AtomicSet(&mQuit, 0);
+    SDL_AtomicSet(&mPlaying, 0);
+    SDL_AtomicSet(&mLoop, 0);
+    SDL_AtomicSet(&mEnded, 0);
+    SDL_AtomicSet(&mVolume, MIX_MAX_VOLUME);
+    SDL_AtomicSet(&mUnderruns, 0);
+    SDL_AtomicSet(&mMinBuffered, 0);
+    mFormat = AUDIO_S16SYS;
+    mFrameBytes = 4;
+    mBytesPerSecond = 0;
+    mReadAheadMs = 500;
+}
+
+MusicStream::~MusicStream()
+{
+    close();
+}
+
+void MusicStream::setReadAheadMs(int ms){
+    mReadAheadMs = ms > 1 ? ms : 1;
+}
+
+int MusicStream::getReadAheadMs() const {
+    return mReadAheadMs;
+}
+
+bool MusicStream::open(const char* path)
+{
+    SDL_RWops* src = SDL_RWFromFile(path, "rb");
+    if (src == NULL)
+    {
+        printf("Unable to open %s, Error: %s\n", path, SDL_GetError());
+        return false;
+    }
+    return open(src);
+}
+
+bool MusicStream::open(SDL_RWops* src)
+{
+    close();
+    mSrc = src;
+
+    int frequency;
+    Uint16 format;
+    int channels;
+    SDL_AudioSpec spec;
+    SDL_zero(spec);
+    if (!Mix_QuerySpec(&frequency, &format, &channels))
+    {
+        close();
+        return false;
+    }
+    mDecoder = createMusicDecoder(src);
+    if (mDecoder == NULL)
+    {
+        return openMixerMusic();
+    }
+    if (!mDecoder->open(src, &spec))
+    {
+        close();
+        return false;
+    }
+    mConverter = SDL_NewAudioStream(spec.format, spec.channels, spec.freq, format, (Uint8) channels, frequency);
+    if (mConverter == NULL)
+    {
+        printf("Unable to convert music, Error: %s\n", SDL_GetError());
+        close();
+        return false;
+    }
+
+    mFormat = format;
+    mFrameBytes = SDL_AUDIO_BITSIZE(format) / 8 * channels;
+    mBytesPerSecond = frequency * mFrameBytes;
+    Uint32 ringBytes = MUSIC_MIN_RING_BYTES;
+    while (ringBytes < (Uint32) ((Sint64) mBytesPerSecond * mReadAheadMs / 1000))
+    {
+        ringBytes *= 2;
+    }
+    mRing.assign(ringBytes, 0);
+    mRingMask = ringBytes - 1;
+    mReadBuffer.resize(MUSIC_READ_BYTES);
+    mConvertBuffer.resize(MUSIC_READ_BYTES);
+
+    SDL_AtomicSet(&mReadPos, 0);
+    SDL_AtomicSet(&mWritePos, 0);
+    SDL_AtomicSet(&mQuit, 0);
+    SDL_AtomicSet(&mPlaying, 0);
+    SDL_AtomicSet(&mEnded, 0);
+    SDL_AtomicSet(&mUnderruns, 0);
+    SDL_AtomicSet(&mMinBuffered, (int) ringBytes);
+    mDecoderDone = false;
+
+    mSpaceFreed = SDL_CreateSemaphore(0);
+    mThread = SDL_CreateThread(readerMain, "music_stream", this);
+    if (mThread == NULL)
+    {
+        printf("Unable to start music reader, Error: %s\n", SDL_GetError());
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MusicStream::openMixerMusic()
+{
+    mMusic = Mix_LoadMUS_RW(mSrc, 0);
+    if (mMusic == NULL)
+    {
+        printf("Unable to open music, Error: %s\n", Mix_GetError());
+        close();
+        return false;
+    }
+    printf("music: no streaming decoder for %s, playing through SDL_mixer\n", getMixerMusicTypeName(Mix_GetMusicType(mMusic)));
+    setAudioMixerMusic(true);
+    Mix_VolumeMusic(SDL_AtomicGet(&mVolume));
+    return true;
+}
+
+void MusicStream::close()
+{
+    if (mMusic != NULL)
+    {
+        Mix_HaltMusic();
+        Mix_FreeMusic(mMusic);
+        mMusic = NULL;
+        setAudioMixerMusic(false);
+    }
+    if (mThread != NULL)
+    {
+        SDL_AtomicSet(&mQuit, 1);
+        SDL_SemPost(mSpaceFreed);
+        SDL_WaitThread(mThread, NULL);
+        mThread = NULL;
+    }
+    if (mSpaceFreed != NULL)
+    {
+        SDL_DestroySemaphore(mSpaceFreed);
+        mSpaceFreed = NULL;
+    }
+    if (mConverter != NULL)
+    {
+        SDL_FreeAudioStream(mConverter);
+        mConverter = NULL;
+    }
+    delete mDecoder;
+    mDecoder = NULL;
+    if (mSrc != NULL)
+    {
+        SDL_RWclose(mSrc);
+        mSrc = NULL;
+    }
+
+    std::vector<Uint8>().swap(mRing);
+    std::vector<Uint8>().swap(mReadBuffer);
+    std::vector<Uint8>().swap(mConvertBuffer);
+    mRingMask = 0;
+    SDL_AtomicSet(&mPlaying, 0);
+}
+
+bool MusicStream::usesMixerMusic() const {
+    return mMusic != NULL;
+}
+
+void MusicStream::play(bool loop){
+    if (mMusic != NULL)
+    {
+        if (Mix_PausedMusic())
+        {
+            Mix_ResumeMusic();
+        } else if (Mix_PlayMusic(mMusic, loop ? -1 : 1) < 0) {
+            printf("Unable to play music, Error: %s\n", Mix_GetError());
+        }
+        return;
+    }
+    SDL_AtomicSet(&mLoop, loop ? 1 : 0);
+    SDL_AtomicSet(&mMinBuffered, (int) mRing.size());
+    SDL_AtomicSet(&mPlaying, mThread != NULL ? 1 : 0);
+}
+
+void MusicStream::pause(){
+    if (mMusic != NULL)
+    {
+        Mix_PauseMusic();
+    }
+    SDL_AtomicSet(&mPlaying, 0);
+}
+
+void MusicStream::setVolume(int volume){
+    SDL_AtomicSet(&mVolume, volume < 0 ? 0 : (volume > MIX_MAX_VOLUME ? MIX_MAX_VOLUME : volume));
+    if (mMusic != NULL)
+    {
+        Mix_VolumeMusic(SDL_AtomicGet(&mVolume));
+    }
+}
+
+int SDLCALL MusicStream::readerMain(void* data)
+{
+    MusicStream* stream = (MusicStream*) data;
+    PROFILE_THREAD("music_stream");
+    while (!SDL_AtomicGet(&stream->mQuit))
+    {
+        if (!stream->fill())
+        {
+            // The audio thread posts whenever it frees space; the timeout
+            // only covers a paused stream being closed
+            SDL_SemWaitTimeout(stream->mSpaceFreed, 100);
+        }
+    }
+    return 0;
+}
+
+bool MusicStream::fill()
+{
+    // Only decode once the converter is drained, so it never holds more
+    // than one read worth of audio
+    int available = SDL_AudioStreamAvailable(mConverter);
+    if (available == 0)
+    {
+        if (mDecoderDone)
+        {
+            SDL_AtomicSet(&mEnded, 1);
+            return false;
+        }
+        PROFILE_SCOPE("music decode");
+        int got = mDecoder->read(&mReadBuffer[0], (int) mReadBuffer.size());
+        if (got > 0)
+        {
+            SDL_AudioStreamPut(mConverter, &mReadBuffer[0], got);
+        } else if (got < 0 || !SDL_AtomicGet(&mLoop) || !mDecoder->rewind()) {
+            // Push the resampler's tail out
+            SDL_AudioStreamFlush(mConverter);
+            mDecoderDone = true;
+        }
+        return true;
+    }
+
+    Uint32 readPos = (Uint32) SDL_AtomicGet(&mReadPos);
+    Uint32 writePos = (Uint32) SDL_AtomicGet(&mWritePos);
+    int space = (int) (mRing.size() - (writePos - readPos));
+    int bytes = available < space ? available : space;
+    if (bytes > (int) mConvertBuffer.size())
+    {
+        bytes = (int) mConvertBuffer.size();
+    }
+    bytes -= bytes % mFrameBytes;
+    if (bytes == 0)
+    {
+        return false;
+    }
+
+    bytes = SDL_AudioStreamGet(mConverter, &mConvertBuffer[0], bytes);
+    if (bytes <= 0)
+    {
+        return false;
+    }
+    Uint32 offset = writePos & mRingMask;
+    int first = (int) mRing.size() - (int) offset;
+    if (first > bytes)
+    {
+        first = bytes;
+    }
+    memcpy(&mRing[offset], &mConvertBuffer[0], first);
+    memcpy(&mRing[0], &mConvertBuffer[first], bytes - first);
+    SDL_AtomicSet(&mWritePos, (int) (writePos + (Uint32) bytes));
+    return true;
+}
+
+void MusicStream::mixSource(void* userdata, Uint8* stream, int len)
+{
+    MusicStream* music = (MusicStream*) userdata;
+    if (!SDL_AtomicGet(&music->mPlaying))
+    {
+        return;
+    }
+
+    // Read mEnded first, so a track that ends between the two loads still
+    // counts as running and can't hide an underrun
+    bool ended = SDL_AtomicGet(&music->mEnded) != 0;
+    Uint32 readPos = (Uint32) SDL_AtomicGet(&music->mReadPos);
+    Uint32 writePos = (Uint32) SDL_AtomicGet(&music->mWritePos);
+    int buffered = (int) (writePos - readPos);
+    if (!ended && buffered < SDL_AtomicGet(&music->mMinBuffered))
+    {
+        SDL_AtomicSet(&music->mMinBuffered, buffered);
+    }
+
+    int want = len - len % music->mFrameBytes;
+    int bytes = want < buffered ? want : buffered;
+    if (bytes < want)
+    {
+        if (ended)
+        {
+            if (bytes == 0)
+            {
+                SDL_AtomicSet(&music->mPlaying, 0);
+                return;
+            }
+        } else {
+            SDL_AtomicAdd(&music->mUnderruns, 1);
+        }
+    }
+
+    // The stream is silent here, mixing in applies the volume on the way
+    int volume = SDL_AtomicGet(&music->mVolume);
+    Uint32 offset = readPos & music->mRingMask;
+    int first = (int) music->mRing.size() - (int) offset;
+    if (first > bytes)
+    {
+        first = bytes;
+    }
+    SDL_MixAudioFormat(stream, &music->mRing[offset], music->mFormat, first, volume);
+    SDL_MixAudioFormat(stream + first, &music->mRing[0], music->mFormat, bytes - first, volume);
+    SDL_AtomicSet(&music->mReadPos, (int) (readPos + (Uint32) bytes));
+
+    if (SDL_SemValue(music->mSpaceFreed) == 0)
+    {
+        SDL_SemPost(music->mSpaceFreed);
+    }
+}
+
+bool MusicStream::isPlaying(){
+    if (mMusic != NULL)
+    {
+        return Mix_PlayingMusic() && !Mix_PausedMusic();
+    }
+    return SDL_AtomicGet(&mPlaying) != 0;
+}
+
+int MusicStream::getUnderrunCount(){
+    return SDL_AtomicGet(&mUnderruns);
+}
+
+double MusicStream::getBufferedMs(){
+    if (mBytesPerSecond == 0)
+    {
+        return 0.0;
+    }
+    Uint32 buffered = (Uint32) SDL_AtomicGet(&mWritePos) - (Uint32) SDL_AtomicGet(&mReadPos);
+    return buffered * 1000.0 / mBytesPerSecond;
+}
+
+double MusicStream::getMinBufferedMs(){
+    return mBytesPerSecond > 0 ? SDL_AtomicGet(&mMinBuffered) * 1000.0 / mBytesPerSecond : 0.0;
+}
+
+size_t MusicStream::getMemoryBytes() const {
+    return mRing.size() + mReadBuffer.size() + mConvertBuffer.size();
+}
+
+void MusicStream::printStats(){
+    if (mMusic != NULL)
+    {
+        printf("music: %s through SDL_mixer, not streamed, no read-ahead or underrun stats\n", getMixerMusicTypeName(Mix_GetMusicType(mMusic)));
+        return;
+    }
+    if (mDecoder == NULL)
+    {
+        return;
+    }
+    printf("music: %s, %d ms read-ahead in %d KB, %d underruns, lowest fill %.1f ms\n", mDecoder->getName(),
+        mReadAheadMs, (int) (getMemoryBytes() / 1024), getUnderrunCount(), getMinBufferedMs());
+}
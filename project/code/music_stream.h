@@ -0,0 +1,129 @@
+#ifndef MUSIC_STREAM_H
+#define MUSIC_STREAM_H
+
+#include "SDL.h"
+#include "SDL_mixer.h"
+
+#include <vector>
+
+// Pulls PCM out of an SDL_RWops a piece at a time, never the whole track.
+class MusicDecoder
+{
+    public:
+        virtual ~MusicDecoder() {}
+
+        // Reads the header and fills freq, format and channels of spec.
+        virtual bool open(SDL_RWops* src, SDL_AudioSpec* spec) = 0;
+
+        // Up to bytes of PCM in the spec from open(), whole frames only.
+        // Returns 0 at the end of the track and -1 on errors.
+        virtual int read(Uint8* buffer, int bytes) = 0;
+
+        virtual bool rewind() = 0;
+
+        virtual const char* getName() = 0;
+};
+
+// Picks a decoder from the first bytes of src and leaves src where it was.
+// Only wav is built in, NULL for anything else. Streaming ogg, flac and mp3
+// needs a decoder here and is not done yet.
+MusicDecoder* createMusicDecoder(SDL_RWops* src);
+
+// Background music that is never fully resident. A reader thread decodes
+// the track in fixed size pieces, converts them to the mixer's spec and
+// keeps a ring buffer of read-ahead topped up; the audio thread drains it
+// from the mixer's music source hook. Memory is the ring plus two small
+// buffers, whatever the length of the track.
+//
+// Only wav streams this way so far. Formats without a MusicDecoder (ogg,
+// flac, mp3, ...) are handed to SDL_mixer's Mix_Music so they still play,
+// decoded on the audio thread with no read-ahead, no underrun counting and
+// no stats; see usesMixerMusic().
+//
+// open/play/pause/close are for one thread (the main thread).
+class MusicStream
+{
+    public:
+        MusicStream();
+        ~MusicStream();
+
+        // How much decoded audio to keep ahead of the mixer, i.e. how long a
+        // stalled read may take before the music drops out. Applies from the
+        // next open().
+        void setReadAheadMs(int ms);
+        int getReadAheadMs() const;
+
+        // Needs the mixer open. Takes src over, it is closed by close().
+        // Starts the reader thread, which fills the ring before play().
+        bool open(SDL_RWops* src);
+        bool open(const char* path);
+        // Remove the music source from the mixer first.
+        void close();
+
+        // The open track plays through Mix_Music, don't set mixSource.
+        bool usesMixerMusic() const;
+
+        void play(bool loop);
+        void pause();
+        // 0 to MIX_MAX_VOLUME
+        void setVolume(int volume);
+
+        // AudioMixFunc for setAudioMusicSource(), userdata is the MusicStream.
+        static void mixSource(void* userdata, Uint8* stream, int len);
+
+        // False once a track that doesn't loop has played out.
+        bool isPlaying();
+        // Callbacks that found the ring short while the track was still going.
+        int getUnderrunCount();
+        double getBufferedMs();
+        // Lowest fill level any callback saw since play().
+        double getMinBufferedMs();
+        size_t getMemoryBytes() const;
+
+        void printStats();
+
+    private:
+        MusicStream(const MusicStream&);
+        MusicStream& operator=(const MusicStream&);
+
+        static int SDLCALL readerMain(void* data);
+        // One step of the reader, false when it has to wait for space.
+        bool fill();
+
+        bool openMixerMusic();
+
+        MusicDecoder* mDecoder;
+        Mix_Music* mMusic;
+        SDL_RWops* mSrc;
+        SDL_AudioStream* mConverter;
+        SDL_Thread* mThread;
+        SDL_sem* mSpaceFreed;
+
+        // Written by the reader, read by the audio thread. The positions
+        // count bytes and only ever grow; the ring size is a power of two.
+        std::vector<Uint8> mRing;
+        Uint32 mRingMask;
+        SDL_atomic_t mReadPos;
+        SDL_atomic_t mWritePos;
+
+        std::vector<Uint8> mReadBuffer;
+        std::vector<Uint8> mConvertBuffer;
+
+        SDL_atomic_t mQuit;
+        SDL_atomic_t mPlaying;
+        SDL_atomic_t mLoop;
+        // Reader only: the decoder has nothing more to give
+        bool mDecoderDone;
+        // Set by the reader once the whole track is in the ring
+        SDL_atomic_t mEnded;
+        SDL_atomic_t mVolume;
+        SDL_atomic_t mUnderruns;
+        SDL_atomic_t mMinBuffered;
+
+        Uint16 mFormat;
+        int mFrameBytes;
+        int mBytesPerSecond;
+        int mReadAheadMs;
+};
+
+#endif
@@ -0,0 +1,221 @@
+#include "profiler.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if PROFILER_ENABLED
+
+enum ProfileEventType
+{
+    PROFILE_EVENT_SCOPE = 0,
+    PROFILE_EVENT_COUNTER = 1,
+    PROFILE_EVENT_FRAME = 2
+};
+
+struct ProfileEvent
+{
+    const char* name;
+    Uint64 start;
+    Uint64 end;
+    int value;
+    int type;
+};
+
+// One per thread that ever recorded. Only the owning thread writes; the
+// rings are kept after the thread exits so they still show in the trace.
+struct ProfileThread
+{
+    SDL_threadID id;
+    char name[32];
+    ProfileEvent* events;
+    // count is the owner's copy, writePos what the trace writer may read
+    int count;
+    SDL_atomic_t writePos;
+    // Ring positions of the last finished frame, owning thread only
+    int frameBegin;
+    int frameEnd;
+    int nextFrameBegin;
+    ProfileThread* next;
+};
+
+static SDL_TLSID gProfilerTls = SDL_TLSCreate();
+static SDL_SpinLock gProfilerLock = 0;
+static ProfileThread* gProfilerThreads = NULL;
+static Uint64 gProfilerStart = SDL_GetPerformanceCounter();
+static SDL_atomic_t gProfilerFrames;
+
+// Slow path once per thread, the lock only guards the thread list
+static ProfileThread* createProfileThread()
+{
+    ProfileThread* thread = new ProfileThread();
+    thread->id = SDL_ThreadID();
+    SDL_snprintf(thread->name, sizeof(thread->name), "thread %lu", thread->id);
+    thread->events = new ProfileEvent[PROFILER_RING_EVENTS];
+    thread->count = 0;
+    SDL_AtomicSet(&thread->writePos, 0);
+    thread->frameBegin = 0;
+    thread->frameEnd = 0;
+    thread->nextFrameBegin = 0;
+
+    SDL_AtomicLock(&gProfilerLock);
+    thread->next = gProfilerThreads;
+    gProfilerThreads = thread;
+    SDL_AtomicUnlock(&gProfilerLock);
+
+    SDL_TLSSet(gProfilerTls, thread, NULL);
+    return thread;
+}
+
+static inline ProfileThread* getProfileThread()
+{
+    ProfileThread* thread = (ProfileThread*) SDL_TLSGet(gProfilerTls);
+    return thread != NULL ? thread : createProfileThread();
+}
+
+static inline void pushProfileEvent(ProfileThread* thread, const char* name, Uint64 start, Uint64 end, int value, int type)
+{
+    int pos = thread->count++;
+    ProfileEvent& event = thread->events[pos & (PROFILER_RING_EVENTS - 1)];
+    event.name = name;
+    event.start = start;
+    event.end = end;
+    event.value = value;
+    event.type = type;
+    SDL_AtomicSet(&thread->writePos, pos + 1);
+}
+
+ProfileScope::ProfileScope(const char* name)
+{
+    mName = name;
+    mStart = SDL_GetPerformanceCounter();
+}
+
+ProfileScope::~ProfileScope()
+{
+    Uint64 end = SDL_GetPerformanceCounter();
+    pushProfileEvent(getProfileThread(), mName, mStart, end, 0, PROFILE_EVENT_SCOPE);
+}
+
+void profilerNameThread(const char* name){
+    ProfileThread* thread = getProfileThread();
+    SDL_strlcpy(thread->name, name, sizeof(thread->name));
+}
+
+void profilerCounter(const char* name, int value){
+    Uint64 now = SDL_GetPerformanceCounter();
+    pushProfileEvent(getProfileThread(), name, now, now, value, PROFILE_EVENT_COUNTER);
+}
+
+void profilerFrame(){
+    ProfileThread* thread = getProfileThread();
+    Uint64 now = SDL_GetPerformanceCounter();
+    pushProfileEvent(thread, "frame", now, now, SDL_AtomicAdd(&gProfilerFrames, 1), PROFILE_EVENT_FRAME);
+    thread->frameBegin = thread->nextFrameBegin;
+    thread->frameEnd = thread->count;
+    thread->nextFrameBegin = thread->frameEnd;
+}
+
+int getProfilerFrameCount(){
+    return SDL_AtomicGet(&gProfilerFrames);
+}
+
+double getProfilerLastFrameMs(const char* name)
+{
+    ProfileThread* thread = getProfileThread();
+    int begin = thread->frameBegin;
+    if (thread->frameEnd - begin > PROFILER_RING_EVENTS)
+    {
+        begin = thread->frameEnd - PROFILER_RING_EVENTS;
+    }
+
+    Uint64 ticks = 0;
+    for (int pos = begin; pos < thread->frameEnd; pos++)
+    {
+        const ProfileEvent& event = thread->events[pos & (PROFILER_RING_EVENTS - 1)];
+        if (event.type == PROFILE_EVENT_SCOPE && (event.name == name || strcmp(event.name, name) == 0))
+        {
+            ticks += event.end - event.start;
+        }
+    }
+    return (double) ticks * 1000.0 / (double) SDL_GetPerformanceFrequency();
+}
+
+bool writeChromeTrace(const char* path)
+{
+    FILE* out = fopen(path, "w");
+    if (out == NULL)
+    {
+        printf("Unable to write trace %s\n", path);
+        return false;
+    }
+
+    double usPerTick = 1000000.0 / (double) SDL_GetPerformanceFrequency();
+    fprintf(out, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    bool first = true;
+
+    SDL_AtomicLock(&gProfilerLock);
+    ProfileThread* threads = gProfilerThreads;
+    SDL_AtomicUnlock(&gProfilerLock);
+    for (ProfileThread* thread = threads; thread != NULL; thread = thread->next)
+    {
+        unsigned long tid = thread->id;
+        fprintf(out, "%s{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": %lu, \"args\": {\"name\": \"%s\"}}",
+            first ? "" : ",\n", tid, thread->name);
+        first = false;
+
+        int end = SDL_AtomicGet(&thread->writePos);
+        int begin = end > PROFILER_RING_EVENTS ? end - PROFILER_RING_EVENTS : 0;
+        for (int pos = begin; pos < end; pos++)
+        {
+            const ProfileEvent& event = thread->events[pos & (PROFILER_RING_EVENTS - 1)];
+            double ts = (double) (event.start - gProfilerStart) * usPerTick;
+            switch (event.type)
+            {
+            case PROFILE_EVENT_SCOPE:
+            fprintf(out, ",\n{\"ph\": \"X\", \"name\": \"%s\", \"pid\": 1, \"tid\": %lu, \"ts\": %.3f, \"dur\": %.3f}",
+                event.name, tid, ts, (double) (event.end - event.start) * usPerTick);
+            break;
+
+            case PROFILE_EVENT_COUNTER:
+            fprintf(out, ",\n{\"ph\": \"C\", \"name\": \"%s\", \"pid\": 1, \"tid\": %lu, \"ts\": %.3f, \"args\": {\"value\": %d}}",
+                event.name, tid, ts, event.value);
+            break;
+
+            case PROFILE_EVENT_FRAME:
+            fprintf(out, ",\n{\"ph\": \"i\", \"s\": \"t\", \"name\": \"frame %d\", \"pid\": 1, \"tid\": %lu, \"ts\": %.3f}",
+                event.value, tid, ts);
+            break;
+            }
+        }
+    }
+
+    fprintf(out, "\n]}\n");
+    bool success = ferror(out) == 0;
+    fclose(out);
+    return success;
+}
+
+#else
+
+void profilerNameThread(const char* name){
+}
+
+void profilerCounter(const char* name, int value){
+}
+
+void profilerFrame(){
+}
+
+int getProfilerFrameCount(){
+    return 0;
+}
+
+double getProfilerLastFrameMs(const char* name){
+    return 0.0;
+}
+
+bool writeChromeTrace(const char* path){
+    return false;
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "SDL.h"
+
+// Scoped timers over SDL_GetPerformanceCounter. Every thread writes its
+// finished scopes into its own ring, so the hot path is two counter reads
+// and a store with no locks; the last PROFILER_RING_EVENTS scopes of each
+// thread can be written out as Chrome trace events (chrome://tracing,
+// Perfetto). Internal builds have it on, everything else compiles the
+// macros to nothing. Override with -DPROFILER_ENABLED=0 or 1.
+#ifndef PROFILER_ENABLED
+#if defined(HANDMADE_INTERNAL) && HANDMADE_INTERNAL
+#define PROFILER_ENABLED 1
+#else
+#define PROFILER_ENABLED 0
+#endif
+#endif
+
+// Per thread, 32 bytes each
+const int PROFILER_RING_EVENTS = 1 << 15;
+
+#if PROFILER_ENABLED
+
+// name must be a string literal or otherwise outlive the profiler.
+class ProfileScope
+{
+    public:
+        explicit ProfileScope(const char* name);
+        ~ProfileScope();
+
+    private:
+        ProfileScope(const ProfileScope&);
+        ProfileScope& operator=(const ProfileScope&);
+
+        const char* mName;
+        Uint64 mStart;
+};
+
+#define PROFILE_JOIN2(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN2(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_JOIN(profileScope, __LINE__)(name)
+// Names the calling thread in the trace, call once at thread start.
+#define PROFILE_THREAD(name) profilerNameThread(name)
+// A value graphed over time, e.g. draw calls per frame.
+#define PROFILE_COUNTER(name, value) profilerCounter(name, value)
+#define PROFILE_FRAME() profilerFrame()
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_THREAD(name)
+#define PROFILE_COUNTER(name, value)
+#define PROFILE_FRAME()
+
+#endif
+
+void profilerNameThread(const char* name);
+void profilerCounter(const char* name, int value);
+// Marks the end of a frame on the calling thread.
+void profilerFrame();
+int getProfilerFrameCount();
+
+// Time the calling thread spent in scopes called name during the last
+// finished frame. 0 when compiled out.
+double getProfilerLastFrameMs(const char* name);
+
+// Writes what the rings still hold. Threads that keep recording while this
+// runs may tear their oldest events, call it once they are quiet.
+bool writeChromeTrace(const char* path);
+
+#endif
@@ -0,0 +1,438 @@
+// Headless rendering benchmark. Runs LTexture and LButton style drawing on
+// the software renderer into an offscreen surface under the dummy video
+// driver, so it needs no window and gives the same work on every machine.
+// Writes one JSON document with frame time percentiles, draws per second
+// and heap allocations per frame for every scenario.
+//
+//   render_bench [-frames N] [-o out.json] [scenario ...]
+#include "SDL.h"
+#include "SDL_ttf.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "profiler.cpp"
+// Always count, the bench build does not set HANDMADE_INTERNAL
+#define ALLOC_TRACKING_ENABLED 1
+#include "alloc_tracker.cpp"
+#include "sprite_atlas.cpp"
+#include "frame_arena.cpp"
+#include "sprite_batch.cpp"
+#include "render_queue.cpp"
+#include "assets.cpp"
+#include "texture_cache.cpp"
+#include "ltexture.cpp"
+#include "glyph_cache.cpp"
+#include "hud.cpp"
+
+SDL_Renderer* sdlRenderer = NULL;
+AssetCache gAssets;
+TextureCache gTextureCache;
+TTF_Font* gFont = NULL;
+
+static const int TARGET_WIDTH = 1024;
+static const int TARGET_HEIGHT = 768;
+static const int WARMUP_FRAMES = 10;
+static const int BUTTON_SIZE = 48;
+static const int BUTTON_STATES = 4;
+
+static double secondsSince(Uint64 start)
+{
+    return (double) (SDL_GetPerformanceCounter() - start) / (double) SDL_GetPerformanceFrequency();
+}
+
+static SDL_Surface* makeButtonSheet()
+{
+    SDL_Surface* sheet = SDL_CreateRGBSurfaceWithFormat(0, BUTTON_SIZE * BUTTON_STATES, BUTTON_SIZE, 32, SDL_PIXELFORMAT_ARGB8888);
+    for (int i = 0; i < BUTTON_STATES; i++)
+    {
+        SDL_Rect outer = {i * BUTTON_SIZE, 0, BUTTON_SIZE, BUTTON_SIZE};
+        SDL_Rect inner = {i * BUTTON_SIZE + 4, 4, BUTTON_SIZE - 8, BUTTON_SIZE - 8};
+        SDL_FillRect(sheet, &outer, SDL_MapRGBA(sheet->format, (Uint8) (60 * i), 0x80, (Uint8) (0xFF - 60 * i), 0xFF));
+        SDL_FillRect(sheet, &inner, SDL_MapRGBA(sheet->format, (Uint8) (30 * i), 0x40, (Uint8) (0x80 - 30 * i), 0xC0));
+    }
+    return sheet;
+}
+
+// Shared by all scenarios, built once in main()
+static LTexture gSheet;
+static SDL_Rect gClips[BUTTON_STATES];
+static std::vector<SDL_Point> gButtons;
+static SpriteBatch gBatch;
+static LTexture gTile;
+static LTexture gTag;
+static FrameArena gFrameArena;
+static RenderQueue gRenderQueue;
+static GlyphCache gGlyphs;
+static PerfHud gHud;
+static int gFrame = 0;
+// Texture state changes of the frame, set by scenarios that know them
+static int gStateChanges = -1;
+
+static const SDL_Color BUTTON_TINTS[BUTTON_STATES] = {
+    {0xFF, 0xFF, 0xFF, 0xFF},
+    {0xFF, 0xC0, 0xC0, 0xFF},
+    {0xC0, 0xFF, 0xC0, 0xFF},
+    {0xC0, 0xC0, 0xFF, 0xFF}
+};
+
+// Clear and present only, the baseline every other scenario pays.
+static int drawNothing()
+{
+    return 0;
+}
+
+static int drawBlits()
+{
+    const int draws = 2000;
+    for (int i = 0; i < draws; i++)
+    {
+        gSheet.render((i * 37) % (TARGET_WIDTH - BUTTON_SIZE), (i * 53) % (TARGET_HEIGHT - BUTTON_SIZE), &gClips[i % BUTTON_STATES]);
+    }
+    return draws;
+}
+
+static int drawScaled()
+{
+    const int draws = 2000;
+    for (int i = 0; i < draws; i++)
+    {
+        SDL_Rect dst = {(i * 37) % (TARGET_WIDTH - 2 * BUTTON_SIZE), (i * 53) % (TARGET_HEIGHT - 2 * BUTTON_SIZE), BUTTON_SIZE * 3 / 2, BUTTON_SIZE * 3 / 2};
+        gSheet.render(dst, &gClips[i % BUTTON_STATES]);
+    }
+    return draws;
+}
+
+static int drawRotated()
+{
+    const int draws = 500;
+    for (int i = 0; i < draws; i++)
+    {
+        gSheet.render((i * 37) % (TARGET_WIDTH - 2 * BUTTON_SIZE), (i * 53) % (TARGET_HEIGHT - 2 * BUTTON_SIZE), &gClips[i % BUTTON_STATES], (double) ((i + gFrame) % 360));
+    }
+    return draws;
+}
+
+// A screen of buttons drawn the way LButton::render does, with the hover
+// state walking across them.
+static int drawButtons()
+{
+    for (size_t i = 0; i < gButtons.size(); i++)
+    {
+        int state = (int) (i + gFrame) % BUTTON_STATES;
+        gSheet.render(gButtons[i].x, gButtons[i].y, &gClips[state]);
+    }
+    return (int) gButtons.size();
+}
+
+// Same screen through LButton::render(SpriteBatch&).
+static int drawButtonsBatched()
+{
+    for (size_t i = 0; i < gButtons.size(); i++)
+    {
+        int state = (int) (i + gFrame) % BUTTON_STATES;
+        gSheet.render(gBatch, gButtons[i].x, gButtons[i].y, &gClips[state]);
+    }
+    int draws = gBatch.getQuadCount();
+    gBatch.flush(sdlRenderer);
+    return draws;
+}
+
+// Every button as a background tile, a tinted sheet frame and a tag on
+// top, drawn in that order button after button, the way a scene of
+// LTextures is written. Each draw switches texture state.
+static int drawInterleaved()
+{
+    for (size_t i = 0; i < gButtons.size(); i++)
+    {
+        int state = (int) (i + gFrame) % BUTTON_STATES;
+        const SDL_Color& tint = BUTTON_TINTS[state];
+        gTile.render(gButtons[i].x, gButtons[i].y);
+        gSheet.setColor(tint.r, tint.g, tint.b);
+        gSheet.render(gButtons[i].x, gButtons[i].y, &gClips[state]);
+        gTag.render(gButtons[i].x + 4, gButtons[i].y + 4);
+    }
+    gSheet.setColor(0xFF, 0xFF, 0xFF);
+    int draws = (int) gButtons.size() * 3;
+    gStateChanges = draws;
+    return draws;
+}
+
+// Same scene through the render queue, one layer per kind of draw. The
+// buttons don't overlap, so every layer may be sorted.
+static int drawInterleavedQueued()
+{
+    for (size_t i = 0; i < gButtons.size(); i++)
+    {
+        int state = (int) (i + gFrame) % BUTTON_STATES;
+        const SDL_Color& tint = BUTTON_TINTS[state];
+        gTile.render(gRenderQueue, RENDER_LAYER_BACKGROUND, gButtons[i].x, gButtons[i].y);
+        gSheet.setColor(tint.r, tint.g, tint.b);
+        gSheet.render(gRenderQueue, RENDER_LAYER_SCENE, gButtons[i].x, gButtons[i].y, &gClips[state]);
+        gTag.render(gRenderQueue, RENDER_LAYER_TEXT, gButtons[i].x + 4, gButtons[i].y + 4);
+    }
+    gSheet.setColor(0xFF, 0xFF, 0xFF);
+    int draws = gRenderQueue.getCommandCount();
+    gRenderQueue.flush(sdlRenderer);
+    gRenderQueue.endFrame();
+    gStateChanges = gRenderQueue.getStateChanges();
+    return draws;
+}
+
+// A label on every button from the glyph cache.
+static int drawLabels()
+{
+    SDL_Color black = {0, 0, 0, 0xFF};
+    char label[16];
+    for (size_t i = 0; i < gButtons.size(); i++)
+    {
+        SDL_snprintf(label, sizeof(label), "%d", (int) i + gFrame);
+        gGlyphs.draw(gBatch, gButtons[i].x + 4, gButtons[i].y + 4, label, black);
+    }
+    int draws = gBatch.getQuadCount();
+    gBatch.flush(sdlRenderer);
+    return draws;
+}
+
+// The performance overlay on its own. Less clear_only, it should stay well
+// under 0.1 ms.
+static int drawHud()
+{
+    HudStats stats;
+    stats.frameMs = 4.0 + gFrame % 7;
+    stats.intervalMs = 16.7;
+    stats.drawCalls = 300 + gFrame % 50;
+    stats.textureBytes = 12 * 1024 * 1024;
+    stats.voices = gFrame % 8;
+    stats.allocations = 0;
+    gHud.update(stats);
+    gHud.draw(sdlRenderer);
+    return 1;
+}
+
+struct RenderScenario
+{
+    const char* name;
+    int (*frame)();
+    bool needsFont;
+};
+
+static RenderScenario gScenarios[] = {
+    {"clear_only", drawNothing, false},
+    {"ltexture_blit", drawBlits, false},
+    {"ltexture_scaled", drawScaled, false},
+    {"ltexture_rotated", drawRotated, false},
+    {"lbutton_grid", drawButtons, false},
+    {"lbutton_batched", drawButtonsBatched, false},
+    {"interleaved_immediate", drawInterleaved, false},
+    {"interleaved_queued", drawInterleavedQueued, false},
+    {"glyph_labels", drawLabels, true},
+    {"perf_hud", drawHud, true},
+};
+
+// Nearest rank on sorted times
+static double percentile(const std::vector<double>& sorted, double p)
+{
+    int rank = (int) (p / 100.0 * sorted.size() + 0.999999);
+    rank = rank < 1 ? 1 : (rank > (int) sorted.size() ? (int) sorted.size() : rank);
+    return sorted[rank - 1];
+}
+
+static void runScenario(FILE* out, const RenderScenario& scenario, int frames, bool first)
+{
+    fprintf(out, "%s\n    {\"name\": \"%s\"", first ? "" : ",", scenario.name);
+    if (scenario.needsFont && !gGlyphs.isReady())
+    {
+        fprintf(out, ", \"skipped\": \"no font\"}");
+        return;
+    }
+
+    std::vector<double> times(frames);
+    int totalDraws = 0;
+    int stateChanges = 0;
+    Uint32 allocations = 0;
+    Uint32 allocatedBytes = 0;
+    double totalSeconds = 0.0;
+    for (gFrame = -WARMUP_FRAMES; gFrame < frames; gFrame++)
+    {
+        Uint32 allocationsBefore, bytesBefore;
+        getAllocTotals(&allocationsBefore, &bytesBefore);
+        Uint64 start = SDL_GetPerformanceCounter();
+
+        SDL_SetRenderDrawColor(sdlRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+        SDL_RenderClear(sdlRenderer);
+        gStateChanges = -1;
+        int draws = scenario.frame();
+        SDL_RenderPresent(sdlRenderer);
+        gFrameArena.endFrame();
+
+        double seconds = secondsSince(start);
+        if (gFrame >= 0)
+        {
+            times[gFrame] = seconds * 1000.0;
+            totalSeconds += seconds;
+            totalDraws += draws;
+            stateChanges = gStateChanges;
+            Uint32 allocationsAfter, bytesAfter;
+            getAllocTotals(&allocationsAfter, &bytesAfter);
+            allocations += allocationsAfter - allocationsBefore;
+            allocatedBytes += bytesAfter - bytesBefore;
+        }
+    }
+
+    std::sort(times.begin(), times.end());
+    fprintf(out, ", \"frames\": %d, \"draws_per_frame\": %.1f, \"draws_per_second\": %.0f,\n", frames,
+        (double) totalDraws / frames, totalSeconds > 0.0 ? totalDraws / totalSeconds : 0.0);
+    fprintf(out, "     \"frame_ms\": {\"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f},\n",
+        totalSeconds * 1000.0 / frames, percentile(times, 50.0), percentile(times, 90.0), percentile(times, 99.0), times.back());
+    if (stateChanges >= 0)
+    {
+        fprintf(out, "     \"state_changes_per_frame\": %d,\n", stateChanges);
+    }
+    fprintf(out, "     \"allocations_per_frame\": %.2f, \"allocated_bytes_per_frame\": %.1f}", (double) allocations / frames,
+        (double) allocatedBytes / frames);
+}
+
+int main(int argc, char* args[])
+{
+    // Must come before SDL allocates anything
+    installAllocTracking();
+
+    int frames = 200;
+    const char* outPath = NULL;
+    std::vector<const char*> selected;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(args[i], "-frames") == 0 && i + 1 < argc)
+        {
+            i++;
+            frames = atoi(args[i]);
+        } else if (strcmp(args[i], "-o") == 0 && i + 1 < argc) {
+            i++;
+            outPath = args[i];
+        } else {
+            selected.push_back(args[i]);
+        }
+    }
+    if (frames < 1)
+    {
+        frames = 1;
+    }
+
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    if (SDL_Init(SDL_INIT_VIDEO) < 0)
+    {
+        fprintf(stderr, "error initializing: %s\n", SDL_GetError());
+        return 1;
+    }
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, TARGET_WIDTH, TARGET_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    sdlRenderer = target != NULL ? SDL_CreateSoftwareRenderer(target) : NULL;
+    if (sdlRenderer == NULL)
+    {
+        fprintf(stderr, "no software renderer: %s\n", SDL_GetError());
+        SDL_Quit();
+        return 1;
+    }
+
+    SDL_Surface* sheet = makeButtonSheet();
+    gSheet.loadFromSurface(sheet);
+    gSheet.setBlendMode(SDL_BLENDMODE_BLEND);
+    SDL_FreeSurface(sheet);
+    SDL_Surface* tile = SDL_CreateRGBSurfaceWithFormat(0, BUTTON_SIZE, BUTTON_SIZE, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_FillRect(tile, NULL, SDL_MapRGBA(tile->format, 0xE0, 0xE0, 0xE0, 0xFF));
+    gTile.loadFromSurface(tile);
+    SDL_FreeSurface(tile);
+    SDL_Surface* tag = SDL_CreateRGBSurfaceWithFormat(0, BUTTON_SIZE / 2, BUTTON_SIZE / 4, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_FillRect(tag, NULL, SDL_MapRGBA(tag->format, 0x20, 0x20, 0x20, 0xC0));
+    gTag.loadFromSurface(tag);
+    gTag.setBlendMode(SDL_BLENDMODE_BLEND);
+    SDL_FreeSurface(tag);
+    gFrameArena.init(256 * 1024);
+    gRenderQueue.init(&gFrameArena);
+    gRenderQueue.setLayerSorted(RENDER_LAYER_BACKGROUND, true);
+    gRenderQueue.setLayerSorted(RENDER_LAYER_SCENE, true);
+    gRenderQueue.setLayerSorted(RENDER_LAYER_TEXT, true);
+    for (int i = 0; i < BUTTON_STATES; i++)
+    {
+        SDL_Rect clip = {i * BUTTON_SIZE, 0, BUTTON_SIZE, BUTTON_SIZE};
+        gClips[i] = clip;
+    }
+    for (int y = 0; y + BUTTON_SIZE <= TARGET_HEIGHT; y += BUTTON_SIZE + 4)
+    {
+        for (int x = 0; x + BUTTON_SIZE <= TARGET_WIDTH; x += BUTTON_SIZE + 4)
+        {
+            SDL_Point p = {x, y};
+            gButtons.push_back(p);
+        }
+    }
+
+    // Run from the build directory for the font
+    if (TTF_Init() == 0)
+    {
+        gFont = TTF_OpenFont("OpenSans-Regular.ttf", 14);
+        if (gFont != NULL)
+        {
+            gGlyphs.build(sdlRenderer, gFont);
+            gHud.build(sdlRenderer, gFont);
+            gHud.setVisible(true);
+        }
+    }
+
+    FILE* out = outPath != NULL ? fopen(outPath, "w") : stdout;
+    if (out == NULL)
+    {
+        fprintf(stderr, "can't write %s\n", outPath);
+        out = stdout;
+    }
+
+    SDL_RendererInfo info;
+    SDL_GetRendererInfo(sdlRenderer, &info);
+    fprintf(out, "{\n  \"video_driver\": \"%s\", \"renderer\": \"%s\", \"width\": %d, \"height\": %d, \"warmup_frames\": %d,\n",
+        SDL_GetCurrentVideoDriver(), info.name, TARGET_WIDTH, TARGET_HEIGHT, WARMUP_FRAMES);
+    fprintf(out, "  \"scenarios\": [");
+    bool first = true;
+    int count = (int) (sizeof(gScenarios) / sizeof(gScenarios[0]));
+    for (int i = 0; i < count; i++)
+    {
+        bool run = selected.empty();
+        for (size_t s = 0; s < selected.size(); s++)
+        {
+            if (strcmp(selected[s], gScenarios[i].name) == 0)
+            {
+                run = true;
+            }
+        }
+        if (run)
+        {
+            runScenario(out, gScenarios[i], frames, first);
+            first = false;
+        }
+    }
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+
+    gGlyphs.free();
+    gHud.free();
+    gSheet.free();
+    gTile.free();
+    gTag.free();
+    gFrameArena.free();
+    gTextureCache.clear();
+    if (gFont != NULL)
+    {
+        TTF_CloseFont(gFont);
+        gFont = NULL;
+    }
+    TTF_Quit();
+    SDL_DestroyRenderer(sdlRenderer);
+    sdlRenderer = NULL;
+    SDL_FreeSurface(target);
+    SDL_Quit();
+    return 0;
+}
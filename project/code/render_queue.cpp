@@ -0,0 +1,186 @@
+#include "render_queue.h"
+#include "profiler.h"
+
+#include <algorithm>
+
+// Past this the texture id saturates, those draws still come out right but
+// no longer group by texture.
+static const Uint32 RENDER_QUEUE_MAX_TEXTURE_ID = 0xFFFF;
+
+RenderQueue::RenderQueue()
+{
+    mArena = NULL;
+    for (int i = 0; i < RENDER_QUEUE_LAYERS; i++)
+    {
+        mLayerSorted[i] = false;
+    }
+    mFrameStateChanges = 0;
+    mFrameUnsortedStateChanges = 0;
+    mStateChanges = 0;
+    mUnsortedStateChanges = 0;
+}
+
+void RenderQueue::init(FrameArena* arena){
+    mArena = arena;
+}
+
+void RenderQueue::setLayerSorted(int layer, bool sorted)
+{
+    SDL_assert(layer >= 0 && layer < RENDER_QUEUE_LAYERS);
+    mLayerSorted[layer] = sorted;
+}
+
+void RenderQueue::draw(int layer, SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect& dst, SDL_Color color, SDL_BlendMode blendMode)
+{
+    drawEx(layer, texture, src, dst, 0.0, NULL, SDL_FLIP_NONE, color, blendMode);
+}
+
+void RenderQueue::drawEx(int layer, SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect& dst, double angle, const SDL_Point* center,
+    SDL_RendererFlip flip, SDL_Color color, SDL_BlendMode blendMode)
+{
+    SDL_assert(layer >= 0 && layer < RENDER_QUEUE_LAYERS);
+    RenderCommand command;
+    command.texture = texture;
+    command.hasSrc = src != NULL;
+    if (src != NULL)
+    {
+        command.src = *src;
+    }
+    command.dst = dst;
+    command.rotated = angle != 0.0 || flip != SDL_FLIP_NONE;
+    command.angle = angle;
+    command.hasCenter = center != NULL;
+    if (center != NULL)
+    {
+        command.center = *center;
+    }
+    command.flip = flip;
+    command.color = color;
+    command.blendMode = blendMode;
+    mKeys.push_back(makeKey(layer, command));
+    mCommands.push_back(command);
+}
+
+Uint32 RenderQueue::getTextureId(SDL_Texture* texture)
+{
+    for (size_t i = 0; i < mTextures.size(); i++)
+    {
+        if (mTextures[i] == texture)
+        {
+            return (Uint32) i;
+        }
+    }
+    if (mTextures.size() >= RENDER_QUEUE_MAX_TEXTURE_ID)
+    {
+        return RENDER_QUEUE_MAX_TEXTURE_ID;
+    }
+    mTextures.push_back(texture);
+    return (Uint32) mTextures.size() - 1;
+}
+
+// layer:8 | texture:16 | blend mode:8 | color mod rgba:32. Unsorted layers
+// only use the layer, the recorded index then keeps their order.
+Uint64 RenderQueue::makeKey(int layer, const RenderCommand& command)
+{
+    Uint64 key = (Uint64) layer << 56;
+    if (!mLayerSorted[layer])
+    {
+        return key;
+    }
+    key |= (Uint64) getTextureId(command.texture) << 40;
+    key |= (Uint64) (command.blendMode & 0xFF) << 32;
+    key |= (Uint64) command.color.r << 24 | (Uint64) command.color.g << 16 | (Uint64) command.color.b << 8 | command.color.a;
+    return key;
+}
+
+bool RenderQueue::compareEntries(const SortEntry& a, const SortEntry& b)
+{
+    if (a.key != b.key)
+    {
+        return a.key < b.key;
+    }
+    return a.index < b.index;
+}
+
+bool RenderQueue::stateDiffers(const RenderCommand* current, const RenderCommand& next)
+{
+    return current == NULL || next.texture != current->texture || next.blendMode != current->blendMode
+        || next.color.r != current->color.r || next.color.g != current->color.g
+        || next.color.b != current->color.b || next.color.a != current->color.a;
+}
+
+void RenderQueue::flush(SDL_Renderer* renderer)
+{
+    PROFILE_SCOPE("RenderQueue::flush");
+    size_t count = mCommands.size();
+    if (count == 0)
+    {
+        return;
+    }
+
+    const RenderCommand* current = NULL;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (stateDiffers(current, mCommands[i]))
+        {
+            mFrameUnsortedStateChanges++;
+        }
+        current = &mCommands[i];
+    }
+
+    SortEntry* entries = mArena->allocArray<SortEntry>(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        entries[i].key = mKeys[i];
+        entries[i].index = (Uint32) i;
+    }
+    std::sort(entries, entries + count, compareEntries);
+
+    current = NULL;
+    for (size_t i = 0; i < count; i++)
+    {
+        const RenderCommand& command = mCommands[entries[i].index];
+        if (stateDiffers(current, command))
+        {
+            SDL_SetTextureColorMod(command.texture, command.color.r, command.color.g, command.color.b);
+            SDL_SetTextureAlphaMod(command.texture, command.color.a);
+            SDL_SetTextureBlendMode(command.texture, command.blendMode);
+            mFrameStateChanges++;
+        }
+        current = &command;
+
+        const SDL_Rect* src = command.hasSrc ? &command.src : NULL;
+        if (command.rotated)
+        {
+            SDL_RenderCopyEx(renderer, command.texture, src, &command.dst, command.angle, command.hasCenter ? &command.center : NULL, command.flip);
+        } else {
+            SDL_RenderCopy(renderer, command.texture, src, &command.dst);
+        }
+    }
+
+    mCommands.clear();
+    mKeys.clear();
+    mTextures.clear();
+}
+
+void RenderQueue::endFrame()
+{
+    mStateChanges = mFrameStateChanges;
+    mUnsortedStateChanges = mFrameUnsortedStateChanges;
+    mFrameStateChanges = 0;
+    mFrameUnsortedStateChanges = 0;
+    PROFILE_COUNTER("state changes", mStateChanges);
+    PROFILE_COUNTER("state changes unsorted", mUnsortedStateChanges);
+}
+
+int RenderQueue::getCommandCount() const {
+    return (int) mCommands.size();
+}
+
+int RenderQueue::getStateChanges() const {
+    return mStateChanges;
+}
+
+int RenderQueue::getUnsortedStateChanges() const {
+    return mUnsortedStateChanges;
+}
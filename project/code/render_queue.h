@@ -0,0 +1,97 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "SDL.h"
+
+#include "frame_arena.h"
+
+#include <vector>
+
+const int RENDER_QUEUE_LAYERS = 256;
+
+enum RenderLayer
+{
+    RENDER_LAYER_BACKGROUND = 0,
+    RENDER_LAYER_SCENE = 1,
+    RENDER_LAYER_TEXT = 2,
+    RENDER_LAYER_OVERLAY = 3
+};
+
+struct RenderCommand
+{
+    SDL_Texture* texture;
+    SDL_Rect src;
+    SDL_Rect dst;
+    // Otherwise the whole texture
+    bool hasSrc;
+    // Goes through SDL_RenderCopyEx
+    bool rotated;
+    double angle;
+    SDL_Point center;
+    bool hasCenter;
+    SDL_RendererFlip flip;
+    SDL_Color color;
+    SDL_BlendMode blendMode;
+};
+
+// Records texture draws for the frame and submits them on flush() ordered
+// by a 64-bit key: layer, then texture, blend mode and color mod. Layers
+// always draw in increasing order. Inside a layer draws keep the order
+// they were recorded in unless the layer is marked sorted, which is only
+// safe where its draws don't overlap. Texture state is only set when it
+// differs from the previous draw.
+class RenderQueue
+{
+    public:
+        RenderQueue();
+
+        // Sort keys for flush() come from arena.
+        void init(FrameArena* arena);
+
+        void setLayerSorted(int layer, bool sorted);
+
+        void draw(int layer, SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect& dst, SDL_Color color, SDL_BlendMode blendMode);
+        void drawEx(int layer, SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect& dst, double angle, const SDL_Point* center,
+            SDL_RendererFlip flip, SDL_Color color, SDL_BlendMode blendMode);
+
+        // Submits and clears the queue. May run more than once a frame,
+        // e.g. once per damaged rect.
+        void flush(SDL_Renderer* renderer);
+
+        // Publishes the frame's state change counts to the profiler.
+        void endFrame();
+
+        int getCommandCount() const;
+        // Texture state switches in the last frame
+        int getStateChanges() const;
+        // What the last frame would have switched drawing in recorded order
+        int getUnsortedStateChanges() const;
+
+    private:
+        struct SortEntry
+        {
+            Uint64 key;
+            Uint32 index;
+        };
+
+        static bool compareEntries(const SortEntry& a, const SortEntry& b);
+        static bool stateDiffers(const RenderCommand* current, const RenderCommand& next);
+
+        Uint64 makeKey(int layer, const RenderCommand& command);
+        Uint32 getTextureId(SDL_Texture* texture);
+
+        FrameArena* mArena;
+        std::vector<RenderCommand> mCommands;
+        std::vector<Uint64> mKeys;
+        // Textures in order of first use since the last flush, the index is
+        // the key's texture id. A frame only touches a handful.
+        std::vector<SDL_Texture*> mTextures;
+        bool mLayerSorted[RENDER_QUEUE_LAYERS];
+
+        int mFrameStateChanges;
+        int mFrameUnsortedStateChanges;
+        int mStateChanges;
+        int mUnsortedStateChanges;
+};
+
+#endif
@@ -0,0 +1,299 @@
+#include "shape_backend.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <utility>
+
+#ifdef _WIN32
+#include "SDL_syswm.h"
+#include <windows.h>
+#endif
+
+void getSkinShapeMode(SDL_Surface* skin, SDL_WindowShapeMode* mode)
+{
+    if (skin->format->Amask != 0)
+    {
+        mode->mode = ShapeModeBinarizeAlpha;
+        mode->parameters.binarizationCutoff = 1;
+        return;
+    }
+
+    Uint32 pixel = 0;
+    int bpp = skin->format->BytesPerPixel;
+    SDL_LockSurface(skin);
+    memcpy(&pixel, skin->pixels, bpp);
+    SDL_UnlockSurface(skin);
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    pixel >>= (4 - bpp) * 8;
+#endif
+
+    SDL_Color key = {0, 0, 0, 0xFF};
+    SDL_GetRGB(pixel, skin->format, &key.r, &key.g, &key.b);
+    mode->mode = ShapeModeColorKey;
+    mode->parameters.colorKey = key;
+}
+
+bool buildShapeMaskFromSurface(SDL_Surface* skin, ShapeMask& mask)
+{
+    SDL_WindowShapeMode mode;
+    getSkinShapeMode(skin, &mode);
+
+    SDL_Surface* pixels = skin;
+    if (skin->format->format != SDL_PIXELFORMAT_ARGB8888)
+    {
+        pixels = SDL_ConvertSurfaceFormat(skin, SDL_PIXELFORMAT_ARGB8888, 0);
+        if (pixels == NULL)
+        {
+            printf("Unable to convert skin for shape mask, Error: %s\n", SDL_GetError());
+            return false;
+        }
+    }
+
+    Uint32 key = 0;
+    Uint32 compareMask = pixels->format->Amask;
+    if (mode.mode == ShapeModeColorKey)
+    {
+        SDL_Color c = mode.parameters.colorKey;
+        key = SDL_MapRGB(pixels->format, c.r, c.g, c.b);
+        compareMask = pixels->format->Rmask | pixels->format->Gmask | pixels->format->Bmask;
+    }
+
+    SDL_LockSurface(pixels);
+    mask.buildFromPixels(pixels->pixels, pixels->w, pixels->h, pixels->pitch, key, compareMask);
+    SDL_UnlockSurface(pixels);
+
+    if (pixels != skin)
+    {
+        SDL_FreeSurface(pixels);
+    }
+    return true;
+}
+
+// SDL_SetWindowShape always takes the whole surface, so the only
+// incremental step available is skipping the call when nothing changed.
+class SDLShapeBackend : public ShapeBackend
+{
+    public:
+        SDLShapeBackend();
+        ~SDLShapeBackend();
+
+        SDL_Window* createWindow(const char* title, int x, int y, int w, int h, Uint32 flags);
+
+        bool setShape(SDL_Surface* skin);
+
+        bool setShapeMask(const ShapeMask& mask);
+
+        const char* getName();
+
+    private:
+        SDL_Window* mWindow;
+        SDL_Surface* mMaskSurface;
+        ShapeMask mMask;
+        ShapeMask mNextMask;
+        bool mHasShape;
+};
+
+SDLShapeBackend::SDLShapeBackend()
+{
+    mWindow = NULL;
+    mMaskSurface = NULL;
+    mHasShape = false;
+}
+
+SDLShapeBackend::~SDLShapeBackend()
+{
+    SDL_FreeSurface(mMaskSurface);
+    mMaskSurface = NULL;
+}
+
+SDL_Window* SDLShapeBackend::createWindow(const char* title, int x, int y, int w, int h, Uint32 flags){
+    mWindow = SDL_CreateShapedWindow(title, x, y, w, h, flags);
+    return mWindow;
+}
+
+bool SDLShapeBackend::setShape(SDL_Surface* skin)
+{
+    if (!buildShapeMaskFromSurface(skin, mNextMask))
+    {
+        return false;
+    }
+
+    int firstRow, endRow;
+    if (mHasShape && !mNextMask.findChangedRows(mMask, &firstRow, &endRow))
+    {
+        return true;
+    }
+
+    SDL_WindowShapeMode mode;
+    getSkinShapeMode(skin, &mode);
+    if (SDL_SetWindowShape(mWindow, skin, &mode) != 0)
+    {
+        printf("Unable to set window shape, Error: %s\n", SDL_GetError());
+        return false;
+    }
+
+    std::swap(mMask, mNextMask);
+    mHasShape = true;
+    return true;
+}
+
+// Paints the mask rects as opaque alpha and lets SDL binarize on alpha.
+bool SDLShapeBackend::setShapeMask(const ShapeMask& mask)
+{
+    int firstRow, endRow;
+    if (mHasShape && !mask.findChangedRows(mMask, &firstRow, &endRow))
+    {
+        return true;
+    }
+
+    if (mMaskSurface == NULL || mMaskSurface->w != mask.getWidth() || mMaskSurface->h != mask.getHeight())
+    {
+        SDL_FreeSurface(mMaskSurface);
+        mMaskSurface = SDL_CreateRGBSurfaceWithFormat(0, mask.getWidth(), mask.getHeight(), 32, SDL_PIXELFORMAT_ARGB8888);
+        if (mMaskSurface == NULL)
+        {
+            printf("Unable to create shape surface, Error: %s\n", SDL_GetError());
+            return false;
+        }
+    }
+
+    SDL_FillRect(mMaskSurface, NULL, 0);
+    const std::vector<ShapeRect>& rects = mask.getRects();
+    for (size_t i = 0; i < rects.size(); i++)
+    {
+        SDL_Rect rect = {rects[i].x, rects[i].y, rects[i].w, rects[i].h};
+        SDL_FillRect(mMaskSurface, &rect, 0xFF000000);
+    }
+
+    SDL_WindowShapeMode mode;
+    mode.mode = ShapeModeBinarizeAlpha;
+    mode.parameters.binarizationCutoff = 1;
+    if (SDL_SetWindowShape(mWindow, mMaskSurface, &mode) != 0)
+    {
+        printf("Unable to set window shape, Error: %s\n", SDL_GetError());
+        return false;
+    }
+
+    mMask = mask;
+    mHasShape = true;
+    return true;
+}
+
+const char* SDLShapeBackend::getName(){
+    return "sdl_shape";
+}
+
+#ifdef _WIN32
+// Keeps the current region around and only replaces the band of rows that
+// changed since the last call.
+class Win32RegionShapeBackend : public ShapeBackend
+{
+    public:
+        Win32RegionShapeBackend();
+        ~Win32RegionShapeBackend();
+
+        SDL_Window* createWindow(const char* title, int x, int y, int w, int h, Uint32 flags);
+
+        bool setShape(SDL_Surface* skin);
+
+        bool setShapeMask(const ShapeMask& mask);
+
+        const char* getName();
+
+    private:
+        SDL_Window* mWindow;
+        HRGN mRegion;
+        ShapeMask mMask;
+        ShapeMask mNextMask;
+};
+
+Win32RegionShapeBackend::Win32RegionShapeBackend()
+{
+    mWindow = NULL;
+    mRegion = NULL;
+}
+
+Win32RegionShapeBackend::~Win32RegionShapeBackend()
+{
+    if (mRegion != NULL)
+    {
+        DeleteObject(mRegion);
+        mRegion = NULL;
+    }
+}
+
+SDL_Window* Win32RegionShapeBackend::createWindow(const char* title, int x, int y, int w, int h, Uint32 flags){
+    mWindow = SDL_CreateWindow(title, x, y, w, h, flags | SDL_WINDOW_BORDERLESS);
+    return mWindow;
+}
+
+bool Win32RegionShapeBackend::setShape(SDL_Surface* skin)
+{
+    if (!buildShapeMaskFromSurface(skin, mNextMask))
+    {
+        return false;
+    }
+    return setShapeMask(mNextMask);
+}
+
+bool Win32RegionShapeBackend::setShapeMask(const ShapeMask& mask)
+{
+    SDL_SysWMinfo wmInfo;
+    SDL_VERSION(&wmInfo.version);
+    if (!SDL_GetWindowWMInfo(mWindow, &wmInfo) || wmInfo.info.win.window == NULL)
+    {
+        printf("Unable to get window handle, Error: %s\n", SDL_GetError());
+        return false;
+    }
+
+    int firstRow, endRow;
+    bool sameSize = mask.getWidth() == mMask.getWidth() && mask.getHeight() == mMask.getHeight();
+    if (mRegion == NULL || !sameSize)
+    {
+        if (mRegion != NULL)
+        {
+            DeleteObject(mRegion);
+        }
+        mRegion = createShapeRegion(mask);
+    } else if (mask.findChangedRows(mMask, &firstRow, &endRow)) {
+        HRGN band = CreateRectRgn(0, firstRow, mask.getWidth(), endRow);
+        CombineRgn(mRegion, mRegion, band, RGN_DIFF);
+        DeleteObject(band);
+
+        HRGN rows = createShapeRegion(mask, firstRow, endRow);
+        CombineRgn(mRegion, mRegion, rows, RGN_OR);
+        DeleteObject(rows);
+    } else {
+        return true;
+    }
+
+    // SetWindowRgn takes ownership of the region it is given
+    HRGN windowRegion = CreateRectRgn(0, 0, 0, 0);
+    CombineRgn(windowRegion, mRegion, NULL, RGN_COPY);
+    SetWindowRgn(wmInfo.info.win.window, windowRegion, TRUE);
+
+    mMask = mask;
+    return true;
+}
+
+const char* Win32RegionShapeBackend::getName(){
+    return "win32_region";
+}
+#endif
+
+ShapeBackend* createShapeBackend(ShapeBackendType type)
+{
+    switch (type)
+    {
+    case SHAPE_BACKEND_SDL:
+    return new SDLShapeBackend();
+
+#ifdef _WIN32
+    case SHAPE_BACKEND_WIN32_REGION:
+    return new Win32RegionShapeBackend();
+#endif
+
+    default:
+    return NULL;
+    }
+}
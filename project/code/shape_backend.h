@@ -0,0 +1,43 @@
+#ifndef SHAPE_BACKEND_H
+#define SHAPE_BACKEND_H
+
+#include "SDL.h"
+#include "SDL_shape.h"
+
+#include "shape_mask.h"
+
+enum ShapeBackendType
+{
+    SHAPE_BACKEND_SDL = 0,
+    SHAPE_BACKEND_WIN32_REGION = 1,
+    SHAPE_BACKEND_TOTAL = 2
+};
+
+// Creates the shaped window and keeps its shape in sync with a skin surface.
+// setShape() may be called every frame; the mask of the previous call is
+// kept and nothing is sent to the windowing system unless a row changed.
+class ShapeBackend
+{
+    public:
+        virtual ~ShapeBackend() {}
+
+        virtual SDL_Window* createWindow(const char* title, int x, int y, int w, int h, Uint32 flags) = 0;
+
+        virtual bool setShape(SDL_Surface* skin) = 0;
+
+        // For masks that were built ahead of time, e.g. read from a cache.
+        virtual bool setShapeMask(const ShapeMask& mask) = 0;
+
+        virtual const char* getName() = 0;
+};
+
+// Returns NULL if the backend is not available on this platform.
+ShapeBackend* createShapeBackend(ShapeBackendType type);
+
+// Skins with an alpha channel are binarized on alpha, everything else is
+// keyed on the color of the top-left pixel.
+void getSkinShapeMode(SDL_Surface* skin, SDL_WindowShapeMode* mode);
+
+bool buildShapeMaskFromSurface(SDL_Surface* skin, ShapeMask& mask);
+
+#endif
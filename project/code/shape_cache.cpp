@@ -0,0 +1,228 @@
+#include "shape_cache.h"
+#include "shape_backend.h"
+#include "mapped_file.h"
+#include "crc32.h"
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include <vector>
+
+static const size_t SHAPE_CACHE_HEADER_BYTES = 12 * sizeof(Uint32);
+
+static Uint32 readLE32(const Uint8* p)
+{
+    return (Uint32) p[0] | ((Uint32) p[1] << 8) | ((Uint32) p[2] << 16) | ((Uint32) p[3] << 24);
+}
+
+static Uint16 readLE16(const Uint8* p)
+{
+    return (Uint16) (p[0] | (p[1] << 8));
+}
+
+static void putLE32(std::vector<Uint8>& out, Uint32 v)
+{
+    out.push_back((Uint8) v);
+    out.push_back((Uint8) (v >> 8));
+    out.push_back((Uint8) (v >> 16));
+    out.push_back((Uint8) (v >> 24));
+}
+
+static void putLE16(std::vector<Uint8>& out, Uint16 v)
+{
+    out.push_back((Uint8) v);
+    out.push_back((Uint8) (v >> 8));
+}
+
+std::string getShapeCachePath(const std::string& assetPath)
+{
+    return assetPath + ".mask";
+}
+
+bool getShapeSourceStat(const std::string& assetPath, ShapeSourceKey* key)
+{
+#ifdef _WIN32
+    struct _stat64 info;
+    if (_stat64(assetPath.c_str(), &info) != 0)
+    {
+        return false;
+    }
+#else
+    struct stat info;
+    if (stat(assetPath.c_str(), &info) != 0)
+    {
+        return false;
+    }
+#endif
+    key->size = (Uint64) info.st_size;
+    key->time = (Uint64) info.st_mtime;
+    key->crc = 0;
+    return true;
+}
+
+bool getShapeSourceKey(const std::string& assetPath, ShapeSourceKey* key)
+{
+    MappedFile file;
+    if (!getShapeSourceStat(assetPath, key) || !file.open(assetPath.c_str()) || file.getSize() != key->size)
+    {
+        return false;
+    }
+    key->crc = crc32(file.getData(), file.getSize());
+    return true;
+}
+
+bool readShapeCache(const std::string& cachePath, const std::string& assetPath, ShapeMask& mask)
+{
+    MappedFile file;
+    if (!file.open(cachePath.c_str()) || file.getSize() < SHAPE_CACHE_HEADER_BYTES)
+    {
+        return false;
+    }
+
+    const Uint8* data = file.getData();
+    Uint32 magic = readLE32(data + 0);
+    Uint32 version = readLE32(data + 4);
+    Uint32 width = readLE32(data + 8);
+    Uint32 height = readLE32(data + 12);
+    Uint64 sourceSize = readLE32(data + 16) | ((Uint64) readLE32(data + 20) << 32);
+    Uint64 sourceTime = readLE32(data + 24) | ((Uint64) readLE32(data + 28) << 32);
+    Uint32 sourceCrc = readLE32(data + 32);
+    Uint32 spanCount = readLE32(data + 36);
+    Uint32 payloadBytes = readLE32(data + 40);
+    Uint32 payloadCrc = readLE32(data + 44);
+
+    if (magic != SHAPE_CACHE_MAGIC || version != SHAPE_CACHE_VERSION)
+    {
+        return false;
+    }
+    // A different size or time is enough to know the asset changed, the
+    // same ones are not: same-size edits within a second, cp -p, restores
+    ShapeSourceKey key;
+    if (!getShapeSourceStat(assetPath, &key) || sourceSize != key.size || sourceTime != key.time)
+    {
+        return false;
+    }
+    if (!getShapeSourceKey(assetPath, &key) || sourceCrc != key.crc)
+    {
+        return false;
+    }
+    if (payloadBytes != file.getSize() - SHAPE_CACHE_HEADER_BYTES || width > 0xFFFF || height > 0xFFFF)
+    {
+        return false;
+    }
+
+    const Uint8* p = data + SHAPE_CACHE_HEADER_BYTES;
+    const Uint8* end = p + payloadBytes;
+    if (crc32(p, payloadBytes) != payloadCrc)
+    {
+        return false;
+    }
+
+    std::vector<ShapeSpan> spans;
+    spans.reserve(spanCount);
+    for (int y = 0; y < (int) height; y++)
+    {
+        if (end - p < 2)
+        {
+            return false;
+        }
+        int runCount = readLE16(p);
+        p += 2;
+        if (end - p < runCount * 4)
+        {
+            return false;
+        }
+        for (int i = 0; i < runCount; i++)
+        {
+            ShapeSpan span;
+            span.y = y;
+            span.x0 = readLE16(p);
+            span.x1 = span.x0 + readLE16(p + 2);
+            spans.push_back(span);
+            p += 4;
+        }
+    }
+
+    if (p != end || spans.size() != spanCount)
+    {
+        return false;
+    }
+    return mask.buildFromSpans((int) width, (int) height, spans.data(), (int) spans.size());
+}
+
+bool writeShapeCache(const std::string& cachePath, const ShapeSourceKey& key, const ShapeMask& mask)
+{
+    const std::vector<ShapeSpan>& spans = mask.getSpans();
+    std::vector<Uint8> payload;
+    payload.reserve(mask.getHeight() * 2 + spans.size() * 4);
+    for (int y = 0; y < mask.getHeight(); y++)
+    {
+        int first = mask.getRowStart(y);
+        int last = mask.getRowStart(y + 1);
+        putLE16(payload, (Uint16) (last - first));
+        for (int i = first; i < last; i++)
+        {
+            putLE16(payload, (Uint16) spans[i].x0);
+            putLE16(payload, (Uint16) (spans[i].x1 - spans[i].x0));
+        }
+    }
+
+    std::vector<Uint8> header;
+    putLE32(header, SHAPE_CACHE_MAGIC);
+    putLE32(header, SHAPE_CACHE_VERSION);
+    putLE32(header, (Uint32) mask.getWidth());
+    putLE32(header, (Uint32) mask.getHeight());
+    putLE32(header, (Uint32) key.size);
+    putLE32(header, (Uint32) (key.size >> 32));
+    putLE32(header, (Uint32) key.time);
+    putLE32(header, (Uint32) (key.time >> 32));
+    putLE32(header, key.crc);
+    putLE32(header, (Uint32) spans.size());
+    putLE32(header, (Uint32) payload.size());
+    putLE32(header, payload.empty() ? crc32(NULL, 0) : crc32(&payload[0], payload.size()));
+
+    // Write beside the real file and swap it in, so a crash never leaves a
+    // half-written cache behind
+    std::string tempPath = cachePath + ".tmp";
+    SDL_RWops* rw = SDL_RWFromFile(tempPath.c_str(), "wb");
+    if (rw == NULL)
+    {
+        return false;
+    }
+    bool success = SDL_RWwrite(rw, &header[0], header.size(), 1) == 1;
+    if (success && !payload.empty())
+    {
+        success = SDL_RWwrite(rw, &payload[0], payload.size(), 1) == 1;
+    }
+    SDL_RWclose(rw);
+
+    if (success)
+    {
+        remove(cachePath.c_str());
+        success = rename(tempPath.c_str(), cachePath.c_str()) == 0;
+    }
+    if (!success)
+    {
+        remove(tempPath.c_str());
+    }
+    return success;
+}
+
+bool loadCachedShapeMask(const std::string& assetPath, ShapeMask& mask)
+{
+    return readShapeCache(getShapeCachePath(assetPath), assetPath, mask);
+}
+
+bool buildShapeMaskCached(const std::string& assetPath, SDL_Surface* skin, ShapeMask& mask)
+{
+    if (!buildShapeMaskFromSurface(skin, mask))
+    {
+        return false;
+    }
+    ShapeSourceKey key;
+    std::string cachePath = getShapeCachePath(assetPath);
+    if (!getShapeSourceKey(assetPath, &key) || !writeShapeCache(cachePath, key, mask))
+    {
+        printf("Unable to write shape cache %s\n", cachePath.c_str());
+    }
+    return true;
+}
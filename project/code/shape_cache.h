@@ -0,0 +1,50 @@
+#ifndef SHAPE_CACHE_H
+#define SHAPE_CACHE_H
+
+#include "SDL.h"
+
+#include "shape_mask.h"
+
+#include <string>
+
+// On-disk cache of a skin's shape mask, stored next to the asset as
+// "<asset>.mask". Layout, all fields little endian:
+//
+//   Uint32 magic 'SMSK', version, width, height
+//   Uint64 sourceSize, sourceTime   of the asset file, as two Uint32 each
+//   Uint32 sourceCrc                CRC-32 of the asset file's bytes
+//   Uint32 spanCount, payloadBytes, payloadCrc
+//   payload, per row:    Uint16 runCount, runCount * (Uint16 x0, Uint16 length)
+//
+// The key is a checksum of the raw asset file, so a hit reads the file but
+// never decodes it. Size and modification time are checked first and turn
+// most stale caches away without reading the asset. A cache whose key,
+// version or payload checksum does not match is treated as missing and
+// rewritten.
+const Uint32 SHAPE_CACHE_MAGIC = 0x4B534D53;
+const Uint32 SHAPE_CACHE_VERSION = 3;
+
+struct ShapeSourceKey
+{
+    Uint64 size;
+    Uint64 time;
+    Uint32 crc;
+};
+
+std::string getShapeCachePath(const std::string& assetPath);
+
+// size and time only, from a stat
+bool getShapeSourceStat(const std::string& assetPath, ShapeSourceKey* key);
+// All of it, reads the whole asset
+bool getShapeSourceKey(const std::string& assetPath, ShapeSourceKey* key);
+
+bool readShapeCache(const std::string& cachePath, const std::string& assetPath, ShapeMask& mask);
+bool writeShapeCache(const std::string& cachePath, const ShapeSourceKey& key, const ShapeMask& mask);
+
+// Call before decoding the asset, false means it has to be decoded and
+// passed to buildShapeMaskCached().
+bool loadCachedShapeMask(const std::string& assetPath, ShapeMask& mask);
+// Scans skin and refreshes the cache.
+bool buildShapeMaskCached(const std::string& assetPath, SDL_Surface* skin, ShapeMask& mask);
+
+#endif
@@ -0,0 +1,264 @@
+#include "shape_mask.h"
+#include "color_key_scan.h"
+
+ShapeMask::ShapeMask()
+{
+    mRowOffsets.assign(1, 0);
+    mPrevRowStart = 0;
+    mRowStart = 0;
+    mWidth = 0;
+    mHeight = 0;
+}
+
+void ShapeMask::clear(){
+    mSpans.clear();
+    mRects.clear();
+    mRowOffsets.assign(1, 0);
+    mPrevRowRects.clear();
+    mRowRects.clear();
+    mPrevRowStart = 0;
+    mRowStart = 0;
+    mWidth = 0;
+    mHeight = 0;
+}
+
+void ShapeMask::buildFromPixels(const void* pixels, int width, int height, int pitch, Uint32 key, Uint32 compareMask)
+{
+    clear();
+    mWidth = width;
+    mHeight = height;
+
+    mRowBits.resize((width + 7) / 8 + 1);
+    Uint8* bits = &mRowBits[0];
+    for (int y = 0; y < height; y++)
+    {
+        const Uint32* row = (const Uint32*) ((const Uint8*) pixels + y * pitch);
+        colorKeyScan(row, width, key, compareMask, bits);
+
+        // Walk the packed mask a byte at a time while it is all clear or all
+        // set, and only drop to single bits around run edges.
+        int x = 0;
+        while (x < width)
+        {
+            while (x < width)
+            {
+                Uint8 rest = (Uint8) (bits[x >> 3] >> (x & 7));
+                if (rest == 0)
+                {
+                    x = (x | 7) + 1;
+                } else if (rest & 1) {
+                    break;
+                } else {
+                    x++;
+                }
+            }
+            if (x >= width)
+            {
+                break;
+            }
+
+            int runStart = x;
+            while (x < width)
+            {
+                Uint8 rest = (Uint8) ((Uint8) ~bits[x >> 3] >> (x & 7));
+                if (rest == 0)
+                {
+                    x = (x | 7) + 1;
+                } else if (rest & 1) {
+                    break;
+                } else {
+                    x++;
+                }
+            }
+            if (x > width)
+            {
+                x = width;
+            }
+            addSpan(y, runStart, x);
+        }
+        endRow();
+    }
+}
+
+bool ShapeMask::buildFromSpans(int width, int height, const ShapeSpan* spans, int count)
+{
+    clear();
+    mWidth = width;
+    mHeight = height;
+
+    int i = 0;
+    for (int y = 0; y < height; y++)
+    {
+        int lastX1 = 0;
+        while (i < count && spans[i].y == y)
+        {
+            const ShapeSpan& span = spans[i];
+            if (span.x0 < lastX1 || span.x1 <= span.x0 || span.x1 > width)
+            {
+                clear();
+                return false;
+            }
+            addSpan(y, span.x0, span.x1);
+            lastX1 = span.x1;
+            i++;
+        }
+        endRow();
+    }
+
+    if (i != count)
+    {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+void ShapeMask::addSpan(int y, int x0, int x1){
+    ShapeSpan span = {y, x0, x1};
+    mSpans.push_back(span);
+}
+
+void ShapeMask::endRow(){
+    // Spans of both rows are sorted by x0, so a single forward walk over the
+    // previous row finds the run that continues straight down, if any.
+    size_t prev = mPrevRowStart;
+    mRowRects.clear();
+    for (size_t i = mRowStart; i < mSpans.size(); i++)
+    {
+        const ShapeSpan& span = mSpans[i];
+        while (prev < mRowStart && mSpans[prev].x0 < span.x0)
+        {
+            prev++;
+        }
+
+        if (prev < mRowStart && mSpans[prev].y == span.y - 1 && mSpans[prev].x0 == span.x0 && mSpans[prev].x1 == span.x1)
+        {
+            int rectIndex = mPrevRowRects[prev - mPrevRowStart];
+            mRects[rectIndex].h++;
+            mRowRects.push_back(rectIndex);
+        } else {
+            ShapeRect rect = {span.x0, span.y, span.x1 - span.x0, 1};
+            mRowRects.push_back((int) mRects.size());
+            mRects.push_back(rect);
+        }
+    }
+
+    mPrevRowRects.swap(mRowRects);
+    mPrevRowStart = mRowStart;
+    mRowStart = mSpans.size();
+    mRowOffsets.push_back((int) mRowStart);
+}
+
+const std::vector<ShapeSpan>& ShapeMask::getSpans() const {
+    return mSpans;
+}
+
+int ShapeMask::getRowStart(int y) const {
+    return mRowOffsets[y];
+}
+
+const std::vector<ShapeRect>& ShapeMask::getRects() const {
+    return mRects;
+}
+
+int ShapeMask::getWidth() const {
+    return mWidth;
+}
+
+int ShapeMask::getHeight() const {
+    return mHeight;
+}
+
+bool ShapeMask::rowEquals(const ShapeMask& other, int y) const
+{
+    int count = mRowOffsets[y + 1] - mRowOffsets[y];
+    if (count != other.mRowOffsets[y + 1] - other.mRowOffsets[y])
+    {
+        return false;
+    }
+    const ShapeSpan* a = mSpans.data() + mRowOffsets[y];
+    const ShapeSpan* b = other.mSpans.data() + other.mRowOffsets[y];
+    for (int i = 0; i < count; i++)
+    {
+        if (a[i].x0 != b[i].x0 || a[i].x1 != b[i].x1)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ShapeMask::findChangedRows(const ShapeMask& previous, int* firstRow, int* endRow) const
+{
+    if (previous.mWidth != mWidth || previous.mHeight != mHeight)
+    {
+        *firstRow = 0;
+        *endRow = mHeight;
+        return true;
+    }
+
+    int first = -1;
+    int last = -1;
+    for (int y = 0; y < mHeight; y++)
+    {
+        if (!rowEquals(previous, y))
+        {
+            if (first < 0)
+            {
+                first = y;
+            }
+            last = y;
+        }
+    }
+
+    if (first < 0)
+    {
+        return false;
+    }
+    *firstRow = first;
+    *endRow = last + 1;
+    return true;
+}
+
+#ifdef _WIN32
+HRGN createShapeRegion(const ShapeMask& mask)
+{
+    return createShapeRegion(mask, 0, mask.getHeight());
+}
+
+HRGN createShapeRegion(const ShapeMask& mask, int firstRow, int endRow)
+{
+    // Rects taller than one row are clipped to the band so a partial update
+    // keeps the merged form.
+    std::vector<RECT> clipped;
+    const std::vector<ShapeRect>& rects = mask.getRects();
+    for (size_t i = 0; i < rects.size(); i++)
+    {
+        const ShapeRect& r = rects[i];
+        int top = r.y > firstRow ? r.y : firstRow;
+        int bottom = r.y + r.h < endRow ? r.y + r.h : endRow;
+        if (top < bottom)
+        {
+            RECT rect;
+            SetRect(&rect, r.x, top, r.x + r.w, bottom);
+            clipped.push_back(rect);
+        }
+    }
+
+    DWORD count = (DWORD) clipped.size();
+    std::vector<char> buffer(sizeof(RGNDATAHEADER) + count * sizeof(RECT));
+
+    RGNDATA* data = (RGNDATA*) &buffer[0];
+    data->rdh.dwSize = sizeof(RGNDATAHEADER);
+    data->rdh.iType = RDH_RECTANGLES;
+    data->rdh.nCount = count;
+    data->rdh.nRgnSize = count * sizeof(RECT);
+    SetRect(&data->rdh.rcBound, 0, firstRow, mask.getWidth(), endRow);
+    if (count > 0)
+    {
+        memcpy(data->Buffer, &clipped[0], count * sizeof(RECT));
+    }
+
+    return ExtCreateRegion(NULL, (DWORD) buffer.size(), data);
+}
+#endif
@@ -0,0 +1,87 @@
+#ifndef SHAPE_MASK_H
+#define SHAPE_MASK_H
+
+#include "SDL_stdinc.h"
+
+#include <vector>
+
+// One horizontal run of opaque pixels on row y, covering [x0, x1).
+struct ShapeSpan
+{
+    int y;
+    int x0;
+    int x1;
+};
+
+struct ShapeRect
+{
+    int x;
+    int y;
+    int w;
+    int h;
+};
+
+// Platform-neutral window shape. Rows are scanned into runs of opaque
+// pixels and runs that repeat unchanged on the next row are merged into
+// one taller rectangle, so a skin ends up as a short list of rects that
+// can be handed to the windowing system in a single call.
+class ShapeMask
+{
+    public:
+        ShapeMask();
+
+        void clear();
+
+        // pixels is a 32-bit buffer, pitch in bytes. A pixel is transparent
+        // when (pixel & compareMask) == (key & compareMask).
+        void buildFromPixels(const void* pixels, int width, int height, int pitch, Uint32 key, Uint32 compareMask);
+
+        // Rebuilds the merged rects from spans that are already known, e.g.
+        // read back from a cache. Spans must be sorted by row, then by x0.
+        bool buildFromSpans(int width, int height, const ShapeSpan* spans, int count);
+
+        const std::vector<ShapeSpan>& getSpans() const;
+
+        // Spans of row y are getSpans()[getRowStart(y)] up to getRowStart(y + 1).
+        int getRowStart(int y) const;
+        const std::vector<ShapeRect>& getRects() const;
+
+        int getWidth() const;
+        int getHeight() const;
+
+        // Returns false when both masks are identical, otherwise the
+        // half-open row range [firstRow, endRow) that covers every change.
+        bool findChangedRows(const ShapeMask& previous, int* firstRow, int* endRow) const;
+
+    private:
+        bool rowEquals(const ShapeMask& other, int y) const;
+
+        void addSpan(int y, int x0, int x1);
+        void endRow();
+
+        std::vector<ShapeSpan> mSpans;
+        std::vector<ShapeRect> mRects;
+        std::vector<int> mRowOffsets;
+
+        // Rect index of every span on the previous and current row.
+        std::vector<int> mPrevRowRects;
+        std::vector<int> mRowRects;
+        std::vector<Uint8> mRowBits;
+        size_t mPrevRowStart;
+        size_t mRowStart;
+
+        int mWidth;
+        int mHeight;
+};
+
+#ifdef _WIN32
+#include <windows.h>
+
+// Builds the whole region with one ExtCreateRegion call. Caller owns the HRGN.
+HRGN createShapeRegion(const ShapeMask& mask);
+
+// Same, restricted to rows [firstRow, endRow).
+HRGN createShapeRegion(const ShapeMask& mask, int firstRow, int endRow);
+#endif
+
+#endif
@@ -0,0 +1,300 @@
+#include "soft_mixer.h"
+#include "alloc_tracker.h"
+
+#include <math.h>
+#include <string.h>
+
+static const int SOFT_MIX_QUEUE_CAPACITY = 256;
+// Accumulator size, longer callbacks are mixed in several blocks
+static const int SOFT_MIX_BLOCK_FRAMES = 512;
+// Long enough that gain steps don't click, short enough to feel immediate
+static const int SOFT_MIX_RAMP_MS = 5;
+// Handles are (generation << 16) | slot, kept positive
+static const int SOFT_MIX_MAX_VOICES = 0x10000;
+static const int SOFT_MIX_GENERATION_MASK = 0x7FFF;
+
+SoftMixer::SoftMixer()
+    : mCommands(SOFT_MIX_QUEUE_CAPACITY)
+{
+    mPath = MIX_KERNEL_SCALAR;
+    getMixKernels(mPath, &mKernels);
+    mRampFrames = 1;
+}
+
+bool SoftMixer::init(int frequency, int maxVoices, MixKernelPath path)
+{
+    if (!getMixKernels(path, &mKernels))
+    {
+        path = MIX_KERNEL_SCALAR;
+        getMixKernels(path, &mKernels);
+    }
+    mPath = path;
+    if (maxVoices > SOFT_MIX_MAX_VOICES)
+    {
+        maxVoices = SOFT_MIX_MAX_VOICES;
+    }
+
+    Voice idle;
+    memset(&idle, 0, sizeof(idle));
+    mVoices.assign(maxVoices, idle);
+    mVoiceStates.resize(maxVoices);
+    mGenerations.assign(maxVoices, 0);
+    for (int i = 0; i < maxVoices; i++)
+    {
+        SDL_AtomicSet(&mVoiceStates[i], 0);
+    }
+    mAccum.resize(SOFT_MIX_BLOCK_FRAMES * 2);
+    mRampFrames = frequency * SOFT_MIX_RAMP_MS / 1000;
+    if (mRampFrames < 1)
+    {
+        mRampFrames = 1;
+    }
+    return maxVoices > 0;
+}
+
+int SoftMixer::play(const SoftSound* sound, float gain, float pan, bool loop)
+{
+    ALLOC_SCOPE(ALLOC_SUBSYSTEM_AUDIO);
+    if (sound == NULL || sound->frames <= 0)
+    {
+        return -1;
+    }
+    for (int i = 0; i < (int) mVoiceStates.size(); i++)
+    {
+        if (SDL_AtomicCAS(&mVoiceStates[i], 0, 1))
+        {
+            mGenerations[i] = (mGenerations[i] + 1) & SOFT_MIX_GENERATION_MASK;
+            int handle = (mGenerations[i] << 16) | i;
+            Command command = {COMMAND_PLAY, handle, sound, gain, pan, loop};
+            if (!mCommands.push(command))
+            {
+                SDL_AtomicSet(&mVoiceStates[i], 0);
+                return -1;
+            }
+            return handle;
+        }
+    }
+    return -1;
+}
+
+void SoftMixer::setGain(int handle, float gain)
+{
+    Command command = {COMMAND_GAIN, handle, NULL, gain, 0.0f, false};
+    mCommands.push(command);
+}
+
+void SoftMixer::setPan(int handle, float pan)
+{
+    Command command = {COMMAND_PAN, handle, NULL, 0.0f, pan, false};
+    mCommands.push(command);
+}
+
+void SoftMixer::stop(int handle)
+{
+    Command command = {COMMAND_STOP, handle, NULL, 0.0f, 0.0f, false};
+    mCommands.push(command);
+}
+
+void SoftMixer::apply(const Command& command)
+{
+    int slot = command.handle & 0xFFFF;
+    int generation = command.handle >> 16;
+    if (command.handle < 0 || slot >= (int) mVoices.size())
+    {
+        return;
+    }
+    Voice& voice = mVoices[slot];
+    // The voice this was meant for has ended and the slot was reused
+    if (command.type != COMMAND_PLAY && voice.generation != generation)
+    {
+        return;
+    }
+
+    switch (command.type)
+    {
+    case COMMAND_PLAY:
+    voice.sound = command.sound;
+    voice.generation = generation;
+    voice.position = 0;
+    voice.loop = command.loop;
+    voice.stopping = false;
+    voice.gain = command.value;
+    voice.pan = command.pan;
+    // A new voice starts at its level, only later changes ramp
+    retarget(voice);
+    voice.currentL = voice.targetL;
+    voice.currentR = voice.targetR;
+    voice.rampLeft = 0;
+    break;
+
+    case COMMAND_GAIN:
+    if (voice.sound != NULL && !voice.stopping)
+    {
+        voice.gain = command.value;
+        retarget(voice);
+    }
+    break;
+
+    case COMMAND_PAN:
+    if (voice.sound != NULL && !voice.stopping)
+    {
+        voice.pan = command.pan;
+        retarget(voice);
+    }
+    break;
+
+    case COMMAND_STOP:
+    if (voice.sound != NULL)
+    {
+        voice.stopping = true;
+        voice.gain = 0.0f;
+        retarget(voice);
+    }
+    break;
+    }
+}
+
+// Equal power pan, float sources are scaled to 16-bit units here once.
+void SoftMixer::retarget(Voice& voice)
+{
+    float pan = voice.pan < -1.0f ? -1.0f : (voice.pan > 1.0f ? 1.0f : voice.pan);
+    float angle = (pan + 1.0f) * (float) M_PI / 4.0f;
+    float scale = voice.sound->format == SOFT_SAMPLE_F32 ? 32767.0f : 1.0f;
+    voice.targetL = voice.gain * cosf(angle) * scale;
+    voice.targetR = voice.gain * sinf(angle) * scale;
+    voice.rampLeft = mRampFrames;
+}
+
+void SoftMixer::release(int voice)
+{
+    mVoices[voice].sound = NULL;
+    SDL_AtomicSet(&mVoiceStates[voice], 0);
+}
+
+void SoftMixer::mixVoice(Voice& voice, float* accum, int frames)
+{
+    int done = 0;
+    while (done < frames && voice.sound != NULL)
+    {
+        const SoftSound* sound = voice.sound;
+        int count = frames - done;
+        if (count > sound->frames - voice.position)
+        {
+            count = sound->frames - voice.position;
+        }
+
+        float stepL = 0.0f;
+        float stepR = 0.0f;
+        if (voice.rampLeft > 0)
+        {
+            if (count > voice.rampLeft)
+            {
+                count = voice.rampLeft;
+            }
+            stepL = (voice.targetL - voice.currentL) / voice.rampLeft;
+            stepR = (voice.targetR - voice.currentR) / voice.rampLeft;
+        }
+
+        if (sound->format == SOFT_SAMPLE_F32)
+        {
+            const float* src = (const float*) sound->samples + voice.position * 2;
+            mKernels.accumulateF32(accum + done * 2, src, count, voice.currentL, voice.currentR, stepL, stepR);
+        } else {
+            const Sint16* src = (const Sint16*) sound->samples + voice.position * 2;
+            mKernels.accumulateS16(accum + done * 2, src, count, voice.currentL, voice.currentR, stepL, stepR);
+        }
+
+        if (voice.rampLeft > 0)
+        {
+            voice.rampLeft -= count;
+            voice.currentL += stepL * count;
+            voice.currentR += stepR * count;
+            if (voice.rampLeft == 0)
+            {
+                voice.currentL = voice.targetL;
+                voice.currentR = voice.targetR;
+                if (voice.stopping)
+                {
+                    release((int) (&voice - &mVoices[0]));
+                    return;
+                }
+            }
+        }
+
+        voice.position += count;
+        done += count;
+        if (voice.position >= sound->frames)
+        {
+            if (voice.loop)
+            {
+                voice.position = 0;
+            } else {
+                release((int) (&voice - &mVoices[0]));
+            }
+        }
+    }
+}
+
+void SoftMixer::mix(Sint16* stream, int frames)
+{
+    Command command;
+    while (mCommands.pop(&command))
+    {
+        apply(command);
+    }
+
+    int offset = 0;
+    while (offset < frames)
+    {
+        int count = frames - offset;
+        if (count > SOFT_MIX_BLOCK_FRAMES)
+        {
+            count = SOFT_MIX_BLOCK_FRAMES;
+        }
+
+        bool any = false;
+        for (size_t i = 0; i < mVoices.size(); i++)
+        {
+            if (mVoices[i].sound == NULL)
+            {
+                continue;
+            }
+            if (!any)
+            {
+                memset(&mAccum[0], 0, count * 2 * sizeof(float));
+                any = true;
+            }
+            mixVoice(mVoices[i], &mAccum[0], count);
+        }
+        if (!any)
+        {
+            break;
+        }
+
+        mKernels.resolveS16(stream + offset * 2, &mAccum[0], count * 2);
+        offset += count;
+    }
+}
+
+void SoftMixer::postMix(void* userdata, Uint8* stream, int len)
+{
+    ((SoftMixer*) userdata)->mix((Sint16*) stream, len / (int) (2 * sizeof(Sint16)));
+}
+
+int SoftMixer::getActiveVoices()
+{
+    int active = 0;
+    for (size_t i = 0; i < mVoiceStates.size(); i++)
+    {
+        active += SDL_AtomicGet(&mVoiceStates[i]);
+    }
+    return active;
+}
+
+int SoftMixer::getMaxVoices() const {
+    return (int) mVoices.size();
+}
+
+MixKernelPath SoftMixer::getPath() const {
+    return mPath;
+}
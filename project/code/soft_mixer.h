@@ -0,0 +1,116 @@
+#ifndef SOFT_MIXER_H
+#define SOFT_MIXER_H
+
+#include "SDL.h"
+
+#include "lockfree_queue.h"
+#include "mix_kernels.h"
+
+#include <vector>
+
+enum SoftSampleFormat
+{
+    SOFT_SAMPLE_S16 = 0,
+    SOFT_SAMPLE_F32 = 1
+};
+
+// Interleaved stereo at the device rate. The samples are borrowed and must
+// outlive every voice playing them.
+struct SoftSound
+{
+    SoftSampleFormat format;
+    const void* samples;
+    int frames;
+};
+
+// In-house mixer for UI sounds, run from the mixer's post mix hook and
+// added on top of whatever SDL_mixer produced. Voices are summed with the
+// SIMD kernels into a float buffer and folded into the 16-bit stream with
+// saturation. Gain and pan changes ramp over a few milliseconds.
+//
+// play/setGain/setPan/stop are for one thread (the main thread); they only
+// queue commands that mix() picks up on the audio thread.
+class SoftMixer
+{
+    public:
+        SoftMixer();
+
+        bool init(int frequency, int maxVoices, MixKernelPath path);
+
+        // pan is -1 (left) to 1 (right). Returns a handle for the voice, -1
+        // when all are busy. Handles carry the slot's generation, so one kept
+        // after its sound ended does nothing to a later sound in that slot.
+        int play(const SoftSound* sound, float gain, float pan, bool loop);
+        void setGain(int handle, float gain);
+        void setPan(int handle, float pan);
+        // Fades out over the ramp, then frees the voice.
+        void stop(int handle);
+
+        // Adds every voice into frames of signed 16-bit stereo.
+        void mix(Sint16* stream, int frames);
+
+        // AudioMixFunc for setAudioPostMix(), userdata is the SoftMixer.
+        static void postMix(void* userdata, Uint8* stream, int len);
+
+        int getActiveVoices();
+        int getMaxVoices() const;
+        MixKernelPath getPath() const;
+
+    private:
+        SoftMixer(const SoftMixer&);
+        SoftMixer& operator=(const SoftMixer&);
+
+        enum CommandType
+        {
+            COMMAND_PLAY = 0,
+            COMMAND_GAIN = 1,
+            COMMAND_PAN = 2,
+            COMMAND_STOP = 3
+        };
+
+        struct Command
+        {
+            CommandType type;
+            int handle;
+            const SoftSound* sound;
+            float value;
+            float pan;
+            bool loop;
+        };
+
+        // Audio thread only, apart from state
+        struct Voice
+        {
+            const SoftSound* sound;
+            // Of the play() that started it
+            int generation;
+            int position;
+            bool loop;
+            bool stopping;
+            float gain;
+            float pan;
+            float currentL;
+            float currentR;
+            float targetL;
+            float targetR;
+            int rampLeft;
+        };
+
+        void apply(const Command& command);
+        void retarget(Voice& voice);
+        void mixVoice(Voice& voice, float* accum, int frames);
+        void release(int voice);
+
+        LockFreeQueue<Command> mCommands;
+        std::vector<Voice> mVoices;
+        // 0 free, 1 taken; claimed by play(), released by the audio thread
+        std::vector<SDL_atomic_t> mVoiceStates;
+        // Main thread only, bumped by every play() of the slot
+        std::vector<int> mGenerations;
+        std::vector<float> mAccum;
+        MixKernels mKernels;
+        MixKernelPath mPath;
+        int mRampFrames;
+};
+
+#endif
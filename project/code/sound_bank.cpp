@@ -0,0 +1,237 @@
+#include "sound_bank.h"
+#include "crc32.h"
+
+#include <stdio.h>
+#include <string.h>
+
+struct SoundBankHeader
+{
+    Uint32 magic;
+    Uint32 version;
+    Uint32 frequency;
+    Uint16 format;
+    Uint16 channels;
+    Uint32 count;
+    Uint32 tableCrc;
+};
+
+struct SoundBankEntry
+{
+    char name[SOUND_BANK_NAME_SIZE];
+    Uint32 offset;
+    Uint32 length;
+};
+
+static const Uint32 SOUND_BANK_ALIGN = 16;
+
+bool writeSoundBank(const char* path, const std::vector<std::string>& names, const std::vector<std::string>& files,
+    int frequency, Uint16 format, int channels)
+{
+    if (names.size() != files.size())
+    {
+        return false;
+    }
+
+    std::vector<SoundBankEntry> entries(names.size());
+    std::vector<Uint8> samples;
+    Uint32 dataStart = (Uint32) (sizeof(SoundBankHeader) + entries.size() * sizeof(SoundBankEntry));
+    dataStart = (dataStart + SOUND_BANK_ALIGN - 1) & ~(SOUND_BANK_ALIGN - 1);
+
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        if (names[i].size() >= (size_t) SOUND_BANK_NAME_SIZE)
+        {
+            printf("Sound name too long: %s\n", names[i].c_str());
+            return false;
+        }
+
+        SDL_AudioSpec spec;
+        Uint8* buffer;
+        Uint32 length;
+        if (SDL_LoadWAV(files[i].c_str(), &spec, &buffer, &length) == NULL)
+        {
+            printf("Unable to load %s, Error: %s\n", files[i].c_str(), SDL_GetError());
+            return false;
+        }
+
+        SDL_AudioCVT cvt;
+        if (SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq, format, (Uint8) channels, frequency) < 0)
+        {
+            printf("Unable to convert %s, Error: %s\n", files[i].c_str(), SDL_GetError());
+            SDL_FreeWAV(buffer);
+            return false;
+        }
+        std::vector<Uint8> converted(length * cvt.len_mult);
+        memcpy(&converted[0], buffer, length);
+        SDL_FreeWAV(buffer);
+        cvt.buf = &converted[0];
+        cvt.len = (int) length;
+        if (cvt.needed && SDL_ConvertAudio(&cvt) < 0)
+        {
+            printf("Unable to convert %s, Error: %s\n", files[i].c_str(), SDL_GetError());
+            return false;
+        }
+        Uint32 convertedLength = cvt.needed ? (Uint32) cvt.len_cvt : length;
+
+        SoundBankEntry& entry = entries[i];
+        memset(&entry, 0, sizeof(entry));
+        strcpy(entry.name, names[i].c_str());
+        entry.offset = SDL_SwapLE32(dataStart + (Uint32) samples.size());
+        entry.length = SDL_SwapLE32(convertedLength);
+
+        samples.insert(samples.end(), converted.begin(), converted.begin() + convertedLength);
+        samples.resize((samples.size() + SOUND_BANK_ALIGN - 1) & ~(size_t) (SOUND_BANK_ALIGN - 1), 0);
+    }
+
+    SoundBankHeader header;
+    header.magic = SDL_SwapLE32(SOUND_BANK_MAGIC);
+    header.version = SDL_SwapLE32(SOUND_BANK_VERSION);
+    header.frequency = SDL_SwapLE32((Uint32) frequency);
+    header.format = SDL_SwapLE16(format);
+    header.channels = SDL_SwapLE16((Uint16) channels);
+    header.count = SDL_SwapLE32((Uint32) entries.size());
+    header.tableCrc = SDL_SwapLE32(entries.empty() ? crc32(NULL, 0) : crc32(&entries[0], entries.size() * sizeof(SoundBankEntry)));
+
+    // Same swap as the shape cache, a crash never leaves half a bank behind
+    std::string tempPath = std::string(path) + ".tmp";
+    SDL_RWops* rw = SDL_RWFromFile(tempPath.c_str(), "wb");
+    if (rw == NULL)
+    {
+        printf("Unable to create %s, Error: %s\n", tempPath.c_str(), SDL_GetError());
+        return false;
+    }
+    std::vector<Uint8> padding(dataStart - sizeof(SoundBankHeader) - entries.size() * sizeof(SoundBankEntry), 0);
+    bool success = SDL_RWwrite(rw, &header, sizeof(header), 1) == 1;
+    if (success && !entries.empty())
+    {
+        success = SDL_RWwrite(rw, &entries[0], entries.size() * sizeof(SoundBankEntry), 1) == 1;
+    }
+    if (success && !padding.empty())
+    {
+        success = SDL_RWwrite(rw, &padding[0], padding.size(), 1) == 1;
+    }
+    if (success && !samples.empty())
+    {
+        success = SDL_RWwrite(rw, &samples[0], samples.size(), 1) == 1;
+    }
+    SDL_RWclose(rw);
+
+    if (success)
+    {
+        remove(path);
+        success = rename(tempPath.c_str(), path) == 0;
+    }
+    if (!success)
+    {
+        remove(tempPath.c_str());
+    }
+    return success;
+}
+
+SoundBank::SoundBank()
+{
+}
+
+SoundBank::~SoundBank()
+{
+    close();
+}
+
+bool SoundBank::open(const char* path)
+{
+    close();
+
+    int frequency;
+    Uint16 format;
+    int channels;
+    if (!Mix_QuerySpec(&frequency, &format, &channels))
+    {
+        return false;
+    }
+    if (!mFile.open(path) || mFile.getSize() < sizeof(SoundBankHeader))
+    {
+        mFile.close();
+        return false;
+    }
+
+    SoundBankHeader header;
+    memcpy(&header, mFile.getData(), sizeof(header));
+    Uint32 count = SDL_SwapLE32(header.count);
+    size_t tableBytes = (size_t) count * sizeof(SoundBankEntry);
+    if (SDL_SwapLE32(header.magic) != SOUND_BANK_MAGIC || SDL_SwapLE32(header.version) != SOUND_BANK_VERSION
+        || mFile.getSize() - sizeof(header) < tableBytes)
+    {
+        printf("%s is not a sound bank\n", path);
+        mFile.close();
+        return false;
+    }
+    if ((int) SDL_SwapLE32(header.frequency) != frequency || SDL_SwapLE16(header.format) != format || SDL_SwapLE16(header.channels) != channels)
+    {
+        printf("%s was packed for %u Hz, %u channels, the mixer runs at %d Hz, %d channels\n", path,
+            SDL_SwapLE32(header.frequency), SDL_SwapLE16(header.channels), frequency, channels);
+        mFile.close();
+        return false;
+    }
+
+    const Uint8* table = mFile.getData() + sizeof(header);
+    if (crc32(table, tableBytes) != SDL_SwapLE32(header.tableCrc))
+    {
+        printf("%s has a damaged table\n", path);
+        mFile.close();
+        return false;
+    }
+
+    for (Uint32 i = 0; i < count; i++)
+    {
+        SoundBankEntry entry;
+        memcpy(&entry, table + i * sizeof(SoundBankEntry), sizeof(entry));
+        Uint32 offset = SDL_SwapLE32(entry.offset);
+        Uint32 length = SDL_SwapLE32(entry.length);
+        if (offset > mFile.getSize() || length > mFile.getSize() - offset)
+        {
+            printf("%s has a sound outside the file\n", path);
+            close();
+            return false;
+        }
+        entry.name[SOUND_BANK_NAME_SIZE - 1] = '\0';
+
+        // The mixer only reads the samples, never frees them
+        Mix_Chunk* chunk = Mix_QuickLoad_RAW((Uint8*) mFile.getData() + offset, length);
+        if (chunk == NULL)
+        {
+            printf("Unable to wrap %s, Error: %s\n", entry.name, Mix_GetError());
+            close();
+            return false;
+        }
+        mNames.push_back(entry.name);
+        mChunks.push_back(chunk);
+    }
+    return true;
+}
+
+void SoundBank::close()
+{
+    for (size_t i = 0; i < mChunks.size(); i++)
+    {
+        Mix_FreeChunk(mChunks[i]);
+    }
+    mChunks.clear();
+    mNames.clear();
+    mFile.close();
+}
+
+Mix_Chunk* SoundBank::getChunk(const char* name) const
+{
+    for (size_t i = 0; i < mNames.size(); i++)
+    {
+        if (mNames[i] == name)
+        {
+            return mChunks[i];
+        }
+    }
+    return NULL;
+}
+
+int SoundBank::getCount() const {
+    return (int) mChunks.size();
+}
@@ -0,0 +1,56 @@
+#ifndef SOUND_BANK_H
+#define SOUND_BANK_H
+
+#include "SDL.h"
+#include "SDL_mixer.h"
+
+#include "mapped_file.h"
+
+#include <string>
+#include <vector>
+
+// All sound effects in one file, already converted to the mixer's output
+// format so they can be played straight out of a memory mapping. Layout,
+// header fields little endian, samples in the output format:
+//
+//   Uint32 magic 'SBNK', version, frequency
+//   Uint16 format, channels
+//   Uint32 count, tableCrc   CRC-32 of the entry table
+//   count * { char name[32], Uint32 offset, Uint32 length }
+//   sample data, every sound starting on a 16 byte boundary
+//
+// Only the table is checksummed; hashing the samples would touch every page
+// of the mapping at startup, which is what the bank is there to avoid.
+const Uint32 SOUND_BANK_MAGIC = 0x4B4E4253;
+const Uint32 SOUND_BANK_VERSION = 1;
+const int SOUND_BANK_NAME_SIZE = 32;
+
+// Decodes each WAV file, converts it to the given spec and writes the bank.
+bool writeSoundBank(const char* path, const std::vector<std::string>& names, const std::vector<std::string>& files,
+    int frequency, Uint16 format, int channels);
+
+class SoundBank
+{
+    public:
+        SoundBank();
+        ~SoundBank();
+
+        // Fails if the mixer is not open or runs at a different spec than
+        // the bank was packed for; load the loose files instead then.
+        bool open(const char* path);
+        void close();
+
+        // NULL if the bank has no such sound. The chunk belongs to the bank.
+        Mix_Chunk* getChunk(const char* name) const;
+        int getCount() const;
+
+    private:
+        SoundBank(const SoundBank&);
+        SoundBank& operator=(const SoundBank&);
+
+        MappedFile mFile;
+        std::vector<std::string> mNames;
+        std::vector<Mix_Chunk*> mChunks;
+};
+
+#endif
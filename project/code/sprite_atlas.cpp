@@ -0,0 +1,260 @@
+#include "sprite_atlas.h"
+
+#include <stdio.h>
+
+SkylinePacker::SkylinePacker()
+{
+    mWidth = 0;
+    mHeight = 0;
+    mUsedArea = 0;
+}
+
+void SkylinePacker::init(int width, int height)
+{
+    mWidth = width;
+    mHeight = height;
+    mUsedArea = 0;
+    mSkyline.clear();
+    Node node = {0, 0, width};
+    mSkyline.push_back(node);
+}
+
+// Lowest y a w x h rect can sit at when its left edge is on node index.
+int SkylinePacker::fit(int index, int w, int h) const
+{
+    int x = mSkyline[index].x;
+    if (x + w > mWidth)
+    {
+        return -1;
+    }
+
+    int y = mSkyline[index].y;
+    int widthLeft = w;
+    int i = index;
+    while (widthLeft > 0)
+    {
+        if (i >= (int) mSkyline.size())
+        {
+            return -1;
+        }
+        if (mSkyline[i].y > y)
+        {
+            y = mSkyline[i].y;
+        }
+        if (y + h > mHeight)
+        {
+            return -1;
+        }
+        widthLeft -= mSkyline[i].width;
+        i++;
+    }
+    return y;
+}
+
+bool SkylinePacker::pack(int w, int h, SDL_Rect* out)
+{
+    int bestIndex = -1;
+    int bestBottom = 0;
+    int bestWidth = 0;
+    for (int i = 0; i < (int) mSkyline.size(); i++)
+    {
+        int y = fit(i, w, h);
+        if (y < 0)
+        {
+            continue;
+        }
+        if (bestIndex < 0 || y + h < bestBottom || (y + h == bestBottom && mSkyline[i].width < bestWidth))
+        {
+            bestIndex = i;
+            bestBottom = y + h;
+            bestWidth = mSkyline[i].width;
+        }
+    }
+    if (bestIndex < 0)
+    {
+        return false;
+    }
+
+    out->x = mSkyline[bestIndex].x;
+    out->y = bestBottom - h;
+    out->w = w;
+    out->h = h;
+
+    Node node = {out->x, bestBottom, w};
+    mSkyline.insert(mSkyline.begin() + bestIndex, node);
+
+    // Trim the nodes the new one now covers
+    for (int i = bestIndex + 1; i < (int) mSkyline.size(); i++)
+    {
+        const Node& prev = mSkyline[i - 1];
+        int overlap = prev.x + prev.width - mSkyline[i].x;
+        if (overlap <= 0)
+        {
+            break;
+        }
+        mSkyline[i].x += overlap;
+        mSkyline[i].width -= overlap;
+        if (mSkyline[i].width > 0)
+        {
+            break;
+        }
+        mSkyline.erase(mSkyline.begin() + i);
+        i--;
+    }
+
+    // Merge neighbours at the same height
+    for (int i = 0; i + 1 < (int) mSkyline.size(); i++)
+    {
+        if (mSkyline[i].y == mSkyline[i + 1].y)
+        {
+            mSkyline[i].width += mSkyline[i + 1].width;
+            mSkyline.erase(mSkyline.begin() + i + 1);
+            i--;
+        }
+    }
+
+    mUsedArea += (long) w * h;
+    return true;
+}
+
+float SkylinePacker::getOccupancy() const
+{
+    if (mWidth == 0 || mHeight == 0)
+    {
+        return 0.0f;
+    }
+    return (float) mUsedArea / ((float) mWidth * (float) mHeight);
+}
+
+SpriteAtlas::SpriteAtlas()
+{
+    mPageWidth = 1024;
+    mPageHeight = 1024;
+    mPadding = 1;
+}
+
+SpriteAtlas::~SpriteAtlas()
+{
+    free();
+}
+
+void SpriteAtlas::init(int pageWidth, int pageHeight, int padding)
+{
+    free();
+    mPageWidth = pageWidth;
+    mPageHeight = pageHeight;
+    mPadding = padding;
+}
+
+bool SpriteAtlas::addPage()
+{
+    Page page;
+    page.surface = SDL_CreateRGBSurfaceWithFormat(0, mPageWidth, mPageHeight, 32, SDL_PIXELFORMAT_ARGB8888);
+    page.texture = NULL;
+    if (page.surface == NULL)
+    {
+        printf("Unable to create atlas page, Error: %s\n", SDL_GetError());
+        return false;
+    }
+    SDL_FillRect(page.surface, NULL, 0);
+    page.packer.init(mPageWidth, mPageHeight);
+    mPages.push_back(page);
+    return true;
+}
+
+int SpriteAtlas::add(SDL_Surface* surface, const SDL_Rect* clip)
+{
+    SDL_Rect src = {0, 0, surface->w, surface->h};
+    if (clip != NULL)
+    {
+        src = *clip;
+    }
+    int w = src.w + mPadding;
+    int h = src.h + mPadding;
+    if (w > mPageWidth || h > mPageHeight)
+    {
+        printf("Sprite %dx%d does not fit a %dx%d atlas page\n", src.w, src.h, mPageWidth, mPageHeight);
+        return -1;
+    }
+
+    // Try the newest page first, earlier ones are usually full
+    SDL_Rect slot;
+    int page = (int) mPages.size() - 1;
+    if (page < 0 || mPages[page].surface == NULL || !mPages[page].packer.pack(w, h, &slot))
+    {
+        if (!addPage())
+        {
+            return -1;
+        }
+        page = (int) mPages.size() - 1;
+        mPages[page].packer.pack(w, h, &slot);
+    }
+
+    // Straight copy; color keyed pixels are skipped and stay transparent
+    SDL_BlendMode oldBlend;
+    SDL_GetSurfaceBlendMode(surface, &oldBlend);
+    SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+    SDL_Rect dst = {slot.x, slot.y, src.w, src.h};
+    SDL_BlitSurface(surface, &src, mPages[page].surface, &dst);
+    SDL_SetSurfaceBlendMode(surface, oldBlend);
+
+    AtlasSprite sprite;
+    sprite.page = page;
+    sprite.texture = NULL;
+    sprite.rect = dst;
+    mSprites.push_back(sprite);
+    return (int) mSprites.size() - 1;
+}
+
+bool SpriteAtlas::upload(SDL_Renderer* renderer)
+{
+    for (size_t i = 0; i < mPages.size(); i++)
+    {
+        Page& page = mPages[i];
+        if (page.texture != NULL)
+        {
+            continue;
+        }
+        page.texture = SDL_CreateTextureFromSurface(renderer, page.surface);
+        if (page.texture == NULL)
+        {
+            printf("Unable to create atlas texture, Error: %s\n", SDL_GetError());
+            return false;
+        }
+        SDL_SetTextureBlendMode(page.texture, SDL_BLENDMODE_BLEND);
+        SDL_FreeSurface(page.surface);
+        page.surface = NULL;
+    }
+
+    for (size_t i = 0; i < mSprites.size(); i++)
+    {
+        mSprites[i].texture = mPages[mSprites[i].page].texture;
+    }
+    return true;
+}
+
+void SpriteAtlas::free()
+{
+    for (size_t i = 0; i < mPages.size(); i++)
+    {
+        SDL_FreeSurface(mPages[i].surface);
+        if (mPages[i].texture != NULL)
+        {
+            SDL_DestroyTexture(mPages[i].texture);
+        }
+    }
+    mPages.clear();
+    mSprites.clear();
+}
+
+const AtlasSprite& SpriteAtlas::getSprite(int index) const {
+    return mSprites[index];
+}
+
+int SpriteAtlas::getSpriteCount() const {
+    return (int) mSprites.size();
+}
+
+int SpriteAtlas::getPageCount() const {
+    return (int) mPages.size();
+}
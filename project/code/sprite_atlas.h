@@ -0,0 +1,89 @@
+#ifndef SPRITE_ATLAS_H
+#define SPRITE_ATLAS_H
+
+#include "SDL.h"
+
+#include <vector>
+
+// Skyline bottom-left rectangle packer.
+class SkylinePacker
+{
+    public:
+        SkylinePacker();
+
+        void init(int width, int height);
+
+        // Finds room for a w x h rect; returns false when the page is full.
+        bool pack(int w, int h, SDL_Rect* out);
+
+        // Fraction of the page area handed out so far.
+        float getOccupancy() const;
+
+    private:
+        struct Node
+        {
+            int x;
+            int y;
+            int width;
+        };
+
+        int fit(int index, int w, int h) const;
+
+        std::vector<Node> mSkyline;
+        int mWidth;
+        int mHeight;
+        long mUsedArea;
+};
+
+struct AtlasSprite
+{
+    int page;
+    // NULL until SpriteAtlas::upload()
+    SDL_Texture* texture;
+    SDL_Rect rect;
+};
+
+// Packs loose images, or clips of them, into a few page textures so that
+// sprites from different files can be drawn without switching textures.
+class SpriteAtlas
+{
+    public:
+        SpriteAtlas();
+        ~SpriteAtlas();
+
+        void init(int pageWidth, int pageHeight, int padding);
+
+        // Copies surface, or the clip of it, into a page. Color keyed
+        // pixels become transparent. Returns the sprite index or -1.
+        int add(SDL_Surface* surface, const SDL_Rect* clip);
+
+        // Creates one texture per page and drops the page surfaces.
+        bool upload(SDL_Renderer* renderer);
+
+        void free();
+
+        const AtlasSprite& getSprite(int index) const;
+        int getSpriteCount() const;
+        int getPageCount() const;
+
+    private:
+        SpriteAtlas(const SpriteAtlas&);
+        SpriteAtlas& operator=(const SpriteAtlas&);
+
+        struct Page
+        {
+            SDL_Surface* surface;
+            SDL_Texture* texture;
+            SkylinePacker packer;
+        };
+
+        bool addPage();
+
+        std::vector<Page> mPages;
+        std::vector<AtlasSprite> mSprites;
+        int mPageWidth;
+        int mPageHeight;
+        int mPadding;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#include "sprite_batch.h"
+
+SpriteBatch::SpriteBatch()
+{
+    mStateChanges = 0;
+}
+
+void SpriteBatch::draw(SDL_Texture* texture, const SDL_Rect& src, const SDL_Rect& dst, SDL_Color color, SDL_BlendMode blendMode)
+{
+    SpriteQuad quad;
+    quad.texture = texture;
+    quad.src = src;
+    quad.dst = dst;
+    quad.color = color;
+    quad.blendMode = blendMode;
+    mQuads.push_back(quad);
+}
+
+void SpriteBatch::draw(const AtlasSprite& sprite, int x, int y, SDL_Color color)
+{
+    SDL_Rect dst = {x, y, sprite.rect.w, sprite.rect.h};
+    draw(sprite.texture, sprite.rect, dst, color, SDL_BLENDMODE_BLEND);
+}
+
+void SpriteBatch::flush(SDL_Renderer* renderer)
+{
+    mStateChanges = 0;
+    const SpriteQuad* current = NULL;
+    for (size_t i = 0; i < mQuads.size(); i++)
+    {
+        const SpriteQuad& quad = mQuads[i];
+        if (current == NULL || quad.texture != current->texture || quad.blendMode != current->blendMode
+            || quad.color.r != current->color.r || quad.color.g != current->color.g
+            || quad.color.b != current->color.b || quad.color.a != current->color.a)
+        {
+            SDL_SetTextureColorMod(quad.texture, quad.color.r, quad.color.g, quad.color.b);
+            SDL_SetTextureAlphaMod(quad.texture, quad.color.a);
+            SDL_SetTextureBlendMode(quad.texture, quad.blendMode);
+            mStateChanges++;
+        }
+        current = &quad;
+        SDL_RenderCopy(renderer, quad.texture, &quad.src, &quad.dst);
+    }
+    mQuads.clear();
+}
+
+int SpriteBatch::getQuadCount() const {
+    return (int) mQuads.size();
+}
+
+int SpriteBatch::getStateChanges() const {
+    return mStateChanges;
+}
@@ -0,0 +1,43 @@
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+#include "SDL.h"
+
+#include "sprite_atlas.h"
+
+#include <vector>
+
+struct SpriteQuad
+{
+    SDL_Texture* texture;
+    SDL_Rect src;
+    SDL_Rect dst;
+    SDL_Color color;
+    SDL_BlendMode blendMode;
+};
+
+// Collects quads for a frame and submits them in draw order. Texture color,
+// alpha and blend state are only set when they differ from the previous
+// quad, and each quad goes through plain SDL_RenderCopy, so draws that share
+// an atlas page cost one copy each and no state changes.
+class SpriteBatch
+{
+    public:
+        SpriteBatch();
+
+        void draw(SDL_Texture* texture, const SDL_Rect& src, const SDL_Rect& dst, SDL_Color color, SDL_BlendMode blendMode);
+        void draw(const AtlasSprite& sprite, int x, int y, SDL_Color color);
+
+        // Submits and clears the batch, keeping its storage for next frame.
+        void flush(SDL_Renderer* renderer);
+
+        int getQuadCount() const;
+        // Texture state switches in the last flush.
+        int getStateChanges() const;
+
+    private:
+        std::vector<SpriteQuad> mQuads;
+        int mStateChanges;
+};
+
+#endif
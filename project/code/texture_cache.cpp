@@ -0,0 +1,177 @@
+#include "texture_cache.h"
+
+#include <stdio.h>
+
+TextureCache::TextureCache()
+{
+    mRenderer = NULL;
+    mAssets = NULL;
+    mBudget = 64 * 1024 * 1024;
+    mResidentBytes = 0;
+    mHits = 0;
+    mMisses = 0;
+    mEvictions = 0;
+}
+
+TextureCache::~TextureCache()
+{
+    clear();
+}
+
+void TextureCache::init(SDL_Renderer* renderer, AssetCache* assets){
+    mRenderer = renderer;
+    mAssets = assets;
+}
+
+void TextureCache::setBudget(size_t bytes){
+    mBudget = bytes;
+    evictToBudget();
+}
+
+size_t TextureCache::getBudget() const {
+    return mBudget;
+}
+
+CachedTexture* TextureCache::acquire(const std::string& path, const SDL_Color* colorKey)
+{
+    std::string key = path;
+    if (colorKey != NULL)
+    {
+        char suffix[32];
+        SDL_snprintf(suffix, sizeof(suffix), "#%02x%02x%02x", colorKey->r, colorKey->g, colorKey->b);
+        key += suffix;
+    }
+
+    std::map<std::string, CachedTexture*>::iterator it = mEntries.find(key);
+    if (it != mEntries.end())
+    {
+        CachedTexture* entry = it->second;
+        if (entry->refs == 0)
+        {
+            mIdle.erase(entry->idle);
+        }
+        entry->refs++;
+        mHits++;
+        return entry;
+    }
+
+    SDL_Surface* surface = mAssets->acquireImage(path);
+    if (surface == NULL)
+    {
+        return NULL;
+    }
+
+    // The surface is shared with other asset users, restore its key after upload
+    Uint32 oldKey = 0;
+    bool hadKey = SDL_GetColorKey(surface, &oldKey) == 0;
+    SDL_SetColorKey(surface, colorKey != NULL, colorKey != NULL ? SDL_MapRGB(surface->format, colorKey->r, colorKey->g, colorKey->b) : 0);
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(mRenderer, surface);
+    SDL_SetColorKey(surface, hadKey, oldKey);
+    mAssets->releaseImage(surface);
+
+    if (texture == NULL)
+    {
+        printf("Unable to create texture from %s, Error: %s\n", path.c_str(), SDL_GetError());
+        return NULL;
+    }
+
+    Uint32 format = 0;
+    int width = 0, height = 0;
+    SDL_QueryTexture(texture, &format, NULL, &width, &height);
+
+    CachedTexture* entry = new CachedTexture();
+    entry->key = key;
+    entry->texture = texture;
+    entry->width = width;
+    entry->height = height;
+    entry->bytes = (size_t) width * height * SDL_BYTESPERPIXEL(format);
+    SDL_GetTextureBlendMode(texture, &entry->blendMode);
+    entry->refs = 1;
+    mEntries[key] = entry;
+    mResidentBytes += entry->bytes;
+    mMisses++;
+
+    evictToBudget();
+    return entry;
+}
+
+void TextureCache::release(CachedTexture* entry)
+{
+    if (entry == NULL || entry->refs <= 0)
+    {
+        return;
+    }
+    entry->refs--;
+    if (entry->refs == 0)
+    {
+        entry->idle = mIdle.insert(mIdle.end(), entry);
+        evictToBudget();
+    }
+}
+
+void TextureCache::evictToBudget()
+{
+    while (mResidentBytes > mBudget && !mIdle.empty())
+    {
+        CachedTexture* entry = mIdle.front();
+        mIdle.pop_front();
+        mEntries.erase(entry->key);
+        destroyEntry(entry);
+        mEvictions++;
+    }
+}
+
+void TextureCache::destroyEntry(CachedTexture* entry)
+{
+    mResidentBytes -= entry->bytes;
+    SDL_DestroyTexture(entry->texture);
+    delete entry;
+}
+
+void TextureCache::clear()
+{
+    std::map<std::string, CachedTexture*>::iterator it;
+    for (it = mEntries.begin(); it != mEntries.end(); ++it)
+    {
+        if (it->second->refs > 0)
+        {
+            printf("texture %s destroyed with %d references left\n", it->first.c_str(), it->second->refs);
+        }
+        destroyEntry(it->second);
+    }
+    mEntries.clear();
+    mIdle.clear();
+}
+
+size_t TextureCache::getResidentBytes() const {
+    return mResidentBytes;
+}
+
+int TextureCache::getTextureCount() const {
+    return (int) mEntries.size();
+}
+
+int TextureCache::getHits() const {
+    return mHits;
+}
+
+int TextureCache::getMisses() const {
+    return mMisses;
+}
+
+int TextureCache::getEvictions() const {
+    return mEvictions;
+}
+
+void TextureCache::printStats() const
+{
+    printf("textures: %d resident, %.1f / %.1f KB, %d hits, %d misses, %d evictions\n",
+        (int) mEntries.size(), mResidentBytes / 1024.0, mBudget / 1024.0, mHits, mMisses, mEvictions);
+
+    std::map<std::string, CachedTexture*>::const_iterator it;
+    for (it = mEntries.begin(); it != mEntries.end(); ++it)
+    {
+        const CachedTexture* entry = it->second;
+        printf("  %-32s %4dx%-4d %8.1f KB  %d refs\n", entry->key.c_str(), entry->width, entry->height, entry->bytes / 1024.0, entry->refs);
+    }
+}
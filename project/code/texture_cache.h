@@ -0,0 +1,72 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include "SDL.h"
+
+#include "assets.h"
+
+#include <list>
+#include <map>
+#include <string>
+
+struct CachedTexture
+{
+    std::string key;
+    SDL_Texture* texture;
+    int width;
+    int height;
+    size_t bytes;
+    // Blend mode SDL picked at upload, holders apply their own at render
+    SDL_BlendMode blendMode;
+    int refs;
+    // Position in the idle list while refs == 0
+    std::list<CachedTexture*>::iterator idle;
+};
+
+// Hands out shared textures keyed by path and color key, so widgets that
+// reference the same sprite sheet share one GPU object. Textures nobody
+// holds stay resident and are only destroyed, least recently released
+// first, when the resident total goes over the budget.
+class TextureCache
+{
+    public:
+        TextureCache();
+        ~TextureCache();
+
+        void init(SDL_Renderer* renderer, AssetCache* assets);
+
+        void setBudget(size_t bytes);
+        size_t getBudget() const;
+
+        // colorKey may be NULL for an unkeyed texture. Pair with release().
+        CachedTexture* acquire(const std::string& path, const SDL_Color* colorKey);
+        void release(CachedTexture* entry);
+
+        void clear();
+
+        size_t getResidentBytes() const;
+        int getTextureCount() const;
+        int getHits() const;
+        int getMisses() const;
+        int getEvictions() const;
+        void printStats() const;
+
+    private:
+        TextureCache(const TextureCache&);
+        TextureCache& operator=(const TextureCache&);
+
+        void evictToBudget();
+        void destroyEntry(CachedTexture* entry);
+
+        SDL_Renderer* mRenderer;
+        AssetCache* mAssets;
+        std::map<std::string, CachedTexture*> mEntries;
+        std::list<CachedTexture*> mIdle;
+        size_t mBudget;
+        size_t mResidentBytes;
+        int mHits;
+        int mMisses;
+        int mEvictions;
+};
+
+#endif
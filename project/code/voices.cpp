@@ -0,0 +1,161 @@
+#include "voices.h"
+#include "audio.h"
+#include "alloc_tracker.h"
+
+#include <stdio.h>
+
+VoiceManager::VoiceManager()
+{
+    mSerial = 0;
+    mPlays = 0;
+    mStolen = 0;
+}
+
+void VoiceManager::init()
+{
+    Voice idle = {NULL, 0};
+    mVoices.assign(Mix_AllocateChannels(-1), idle);
+}
+
+void VoiceManager::setPolyphony(Mix_Chunk* chunk, int maxVoices)
+{
+    for (size_t i = 0; i < mLimits.size(); i++)
+    {
+        if (mLimits[i].chunk == chunk)
+        {
+            if (maxVoices > 0)
+            {
+                mLimits[i].maxVoices = maxVoices;
+            } else {
+                mLimits[i] = mLimits.back();
+                mLimits.pop_back();
+            }
+            return;
+        }
+    }
+    if (maxVoices > 0)
+    {
+        Limit limit = {chunk, maxVoices};
+        mLimits.push_back(limit);
+    }
+}
+
+int VoiceManager::getPolyphony(Mix_Chunk* chunk) const
+{
+    for (size_t i = 0; i < mLimits.size(); i++)
+    {
+        if (mLimits[i].chunk == chunk)
+        {
+            return mLimits[i].maxVoices;
+        }
+    }
+    return (int) mVoices.size();
+}
+
+// The mixer may have finished the chunk or something else may have taken
+// the channel since we started it.
+bool VoiceManager::isActive(int channel) const
+{
+    return mVoices[channel].chunk != NULL && Mix_Playing(channel) && Mix_GetChunk(channel) == mVoices[channel].chunk;
+}
+
+int VoiceManager::play(Mix_Chunk* chunk, int loops)
+{
+    ALLOC_SCOPE(ALLOC_SUBSYSTEM_AUDIO);
+    if (chunk == NULL || mVoices.empty())
+    {
+        return -1;
+    }
+
+    int count = (int) mVoices.size();
+    int sameVoices = 0;
+    int oldestSame = -1;
+    int oldest = -1;
+    int freeChannel = -1;
+    for (int i = 0; i < count; i++)
+    {
+        if (!isActive(i))
+        {
+            if (freeChannel < 0 && !Mix_Playing(i))
+            {
+                freeChannel = i;
+            }
+            continue;
+        }
+        if (oldest < 0 || mVoices[i].serial < mVoices[oldest].serial)
+        {
+            oldest = i;
+        }
+        if (mVoices[i].chunk == chunk)
+        {
+            sameVoices++;
+            if (oldestSame < 0 || mVoices[i].serial < mVoices[oldestSame].serial)
+            {
+                oldestSame = i;
+            }
+        }
+    }
+
+    int channel = freeChannel;
+    if (sameVoices >= getPolyphony(chunk))
+    {
+        channel = oldestSame;
+        mStolen++;
+    } else if (channel < 0) {
+        channel = oldest;
+        mStolen++;
+    }
+    if (channel < 0)
+    {
+        return -1;
+    }
+
+    // playChunk() halts whatever is still on the channel
+    channel = playChunk(channel, chunk, loops);
+    if (channel >= 0 && channel < count)
+    {
+        mVoices[channel].chunk = chunk;
+        mVoices[channel].serial = ++mSerial;
+        mPlays++;
+    }
+    return channel;
+}
+
+int VoiceManager::getActiveVoices() const
+{
+    int active = 0;
+    for (int i = 0; i < (int) mVoices.size(); i++)
+    {
+        if (isActive(i))
+        {
+            active++;
+        }
+    }
+    return active;
+}
+
+int VoiceManager::getActiveVoices(Mix_Chunk* chunk) const
+{
+    int active = 0;
+    for (int i = 0; i < (int) mVoices.size(); i++)
+    {
+        if (mVoices[i].chunk == chunk && isActive(i))
+        {
+            active++;
+        }
+    }
+    return active;
+}
+
+int VoiceManager::getPlayCount() const {
+    return mPlays;
+}
+
+int VoiceManager::getStolenCount() const {
+    return mStolen;
+}
+
+void VoiceManager::printStats() const
+{
+    printf("voices: %d of %d active, %d played, %d stolen\n", getActiveVoices(), (int) mVoices.size(), mPlays, mStolen);
+}
@@ -0,0 +1,57 @@
+#ifndef VOICES_H
+#define VOICES_H
+
+#include "SDL.h"
+#include "SDL_mixer.h"
+
+#include <vector>
+
+// Hands out mixer channels. Every chunk can have a polyphony limit; once a
+// chunk hits it, or every channel is busy, the oldest voice is stolen
+// instead of the new sound being dropped or piling up.
+class VoiceManager
+{
+    public:
+        VoiceManager();
+
+        // After openAudio(), manages every channel the mixer has.
+        void init();
+
+        // maxVoices <= 0 removes the limit.
+        void setPolyphony(Mix_Chunk* chunk, int maxVoices);
+
+        // Returns the channel, -1 if chunk is NULL or the mixer is closed.
+        int play(Mix_Chunk* chunk, int loops);
+
+        int getActiveVoices() const;
+        int getActiveVoices(Mix_Chunk* chunk) const;
+        int getPlayCount() const;
+        int getStolenCount() const;
+
+        void printStats() const;
+
+    private:
+        struct Voice
+        {
+            Mix_Chunk* chunk;
+            Uint32 serial;
+        };
+
+        struct Limit
+        {
+            Mix_Chunk* chunk;
+            int maxVoices;
+        };
+
+        bool isActive(int channel) const;
+        int getPolyphony(Mix_Chunk* chunk) const;
+
+        std::vector<Voice> mVoices;
+        std::vector<Limit> mLimits;
+        // Play order, the lowest active serial is the oldest voice
+        Uint32 mSerial;
+        int mPlays;
+        int mStolen;
+};
+
+#endif